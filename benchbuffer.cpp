@@ -0,0 +1,133 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "bytebuffer.h"
+
+#define BENCHBYTES      ( 16U * 1048576U )
+#define BENCHROUNDS     5
+
+enum Access { AC_WORD, AC_LINENO, AC_DWORD, AC_QWORD, AC_REAL32, AC_REAL64 };
+
+static const char* const accessNames[] = {
+    "Word", "LineNo", "DWord", "QWord", "Real32", "Real64"
+};
+
+static const size_t accessSizes[] = { 2U, 3U, 4U, 8U, 4U, 8U };
+
+static volatile uint64_t sink;
+
+// runs stmt n times; the access type is switched outside of the loop
+#define LOOP( stmt )    for ( size_t i=0; i < n; ++i ) { stmt; } break
+
+#define CHECK( call )   if ( !(call) ) { \
+    fprintf( stderr, "bounds check failed\n" ); exit( EXIT_FAILURE ); }
+
+// writes the buffer full with checked write*() calls
+static void writeChecked( ByteBuffer& buf, Access ac, size_t n ) {
+    buf.setWritePos( 0 );
+    switch ( ac ) {
+        case AC_WORD:   LOOP( CHECK( buf.writeWord( (uint16_t) i ) ) );
+        case AC_LINENO: LOOP( CHECK( buf.writeLineNo( (uint32_t) i & 0XFFFFFFU ) ) );
+        case AC_DWORD:  LOOP( CHECK( buf.writeDWord( (uint32_t) i ) ) );
+        case AC_QWORD:  LOOP( CHECK( buf.writeQWord( (uint64_t) i ) ) );
+        case AC_REAL32: LOOP( CHECK( buf.writeReal32( (float) i ) ) );
+        default:        LOOP( CHECK( buf.writeReal64( (double) i ) ) );
+    }
+}
+
+// reserves the space once, then uses the unchecked put*() calls
+static void writeReserved( ByteBuffer& buf, Access ac, size_t n ) {
+    buf.setWritePos( 0 );
+    CHECK( buf.reserve( n * accessSizes[ac] ) );
+    switch ( ac ) {
+        case AC_WORD:   LOOP( buf.putWord( (uint16_t) i ) );
+        case AC_LINENO: LOOP( buf.putLineNo( (uint32_t) i & 0XFFFFFFU ) );
+        case AC_DWORD:  LOOP( buf.putDWord( (uint32_t) i ) );
+        case AC_QWORD:  LOOP( buf.putQWord( (uint64_t) i ) );
+        case AC_REAL32: LOOP( buf.putReal32( (float) i ) );
+        default:        LOOP( buf.putReal64( (double) i ) );
+    }
+}
+
+static void readChecked( ByteBuffer& buf, Access ac, size_t n ) {
+    buf.setReadPos( 0 );
+    uint64_t sum = 0;
+    uint16_t w; uint32_t d; uint64_t q; float f; double r;
+    switch ( ac ) {
+        case AC_WORD:   LOOP( CHECK( buf.readWord( w ) ); sum += w );
+        case AC_LINENO: LOOP( CHECK( buf.readLineNo( d ) ); sum += d );
+        case AC_DWORD:  LOOP( CHECK( buf.readDWord( d ) ); sum += d );
+        case AC_QWORD:  LOOP( CHECK( buf.readQWord( q ) ); sum += q );
+        case AC_REAL32: LOOP( CHECK( buf.readReal32( f ) ); sum += (uint64_t) f );
+        default:        LOOP( CHECK( buf.readReal64( r ) ); sum += (uint64_t) r );
+    }
+    sink = sum;
+}
+
+// checks readAvail() once, then uses the unchecked fetch*() calls
+static void readUnchecked( ByteBuffer& buf, Access ac, size_t n ) {
+    buf.setReadPos( 0 );
+    CHECK( buf.readAvail() >= n * accessSizes[ac] );
+    uint64_t sum = 0;
+    switch ( ac ) {
+        case AC_WORD:   LOOP( sum += buf.fetchWord() );
+        case AC_LINENO: LOOP( sum += buf.fetchLineNo() );
+        case AC_DWORD:  LOOP( sum += buf.fetchDWord() );
+        case AC_QWORD:  LOOP( sum += buf.fetchQWord() );
+        case AC_REAL32: LOOP( sum += (uint64_t) buf.fetchReal32() );
+        default:        LOOP( sum += (uint64_t) buf.fetchReal64() );
+    }
+    sink = sum;
+}
+
+typedef void (*BenchFn)( ByteBuffer& buf, Access ac, size_t n );
+
+static double bench( BenchFn fn, ByteBuffer& buf, Access ac ) {
+    size_t n    = BENCHBYTES / accessSizes[ac];
+    double best = 0;
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        double ti0 = getTime();
+        fn( buf, ac, n );
+        double dif = getTime() - ti0;
+        if ( r == 0 || dif < best ) best = dif;
+    }
+    return (double)( n * accessSizes[ac] ) / best / 1.0e6;
+}
+
+int main( int argc, char** argv ) {
+
+    ByteBuffer buf( BENCHBYTES );
+
+    printf( "MB/s      write  reserve+put       read        fetch\n" );
+    for ( int i=AC_WORD; i <= AC_REAL64; ++i ) {
+        Access ac = (Access) i;
+        double w1 = bench( writeChecked,  buf, ac );
+        double w2 = bench( writeReserved, buf, ac );
+        double r1 = bench( readChecked,   buf, ac );
+        double r2 = bench( readUnchecked, buf, ac );
+        printf( "%-8s %8.0f %12.0f %10.0f %12.0f\n", accessNames[i], 
+            w1, w2, r1, r2 );
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "program.h"
+#include "exception.h"
+#include "benchsource.h"
+
+#define BENCHLINES      50000
+#define BENCHEDITS      200000
+
+static uint32_t rndState = UINT32_C(0X2468ACE1);
+
+static uint32_t rnd( uint32_t rng ) {
+    rndState = rndState * UINT32_C(1103515245) + UINT32_C(12345);
+    return ( ( rndState >> 8U ) * (uint64_t) rng ) >> 24U;
+}
+
+static void enterText( Program& prog, const char* text, size_t len ) {
+    Tokenizer t( (const uint8_t*) text, len );
+    if ( t.tokenize() != T_EOL ) {
+        throw Exception( "tokenize error: %.*s", (int) len, text );
+    }
+    prog.enterLine( t );
+}
+
+int main( int argc, char** argv ) {
+
+    int nLines = BENCHLINES, nEdits = BENCHEDITS;
+    if ( argc > 1 ) nLines = atoi( argv[1] );
+    if ( argc > 2 ) nEdits = atoi( argv[2] );
+    if ( nLines <= 0 ) nLines = BENCHLINES;
+    if ( nEdits <= 0 ) nEdits = BENCHEDITS;
+
+    // split the source into line bodies (without line numbers)
+    size_t len = 0;
+    char*  src = genBenchSource( len, nLines );
+    const char** body    = new const char* [ nLines ];
+    int*         bodyLen = new int [ nLines ];
+    const char*  p = src; const char* end = src + len;
+    for ( int i=0; i < nLines; ++i ) {
+        const char* eol = (const char*) memchr( p, '\n', end - p );
+        if ( eol == 0 ) eol = end;
+        const char* q = p;
+        while ( q < eol && *q != ' ' ) ++q;
+        body[i] = q; bodyLen[i] = (int)( eol - q );
+        p = eol + 1;
+    }
+
+    Program prog;
+    char    line[512];
+    try {
+        double ti0 = getTime();
+        for ( int i=0; i < nLines; ++i ) {
+            int n = snprintf( line, sizeof(line), "%d%.*s", ( i+1 ) * 10, 
+                bodyLen[i], body[i] );
+            enterText( prog, line, (size_t) n );
+        }
+        double ti1 = getTime();
+        printf( "%d lines entered        %10.0f lines/s, %lu bytes\n", nLines,
+            nLines / ( ti1 - ti0 ), (unsigned long) prog.getSize() );
+
+        // replace random lines; every 8th edit deletes a line and 
+        // enters it again
+        for ( int i=0; i < nEdits; ++i ) {
+            int k = (int) rnd( nLines ), b = (int) rnd( nLines );
+            if ( ( i & 7 ) == 7 ) {
+                int n = snprintf( line, sizeof(line), "%d", ( k+1 ) * 10 );
+                enterText( prog, line, (size_t) n );
+            }
+            int n = snprintf( line, sizeof(line), "%d%.*s", ( k+1 ) * 10, 
+                bodyLen[b], body[b] );
+            enterText( prog, line, (size_t) n );
+        }
+        double ti2 = getTime();
+        printf( "%d edits                %10.0f edits/s, %lu bytes, "
+            "%lu dead\n", nEdits, nEdits / ( ti2 - ti1 ), 
+            (unsigned long) prog.getSize(), 
+            (unsigned long) prog.getDeadBytes() );
+
+        // renumber everything, twice, back to the original numbers
+        prog.renum( 100, 100, 0 );
+        prog.renum( 10, 10, 0 );
+        double ti3 = getTime();
+        printf( "RENUM                  %10.3f ms per %d lines\n", 
+            ( ti3 - ti2 ) * 500.0, nLines );
+    }
+    catch ( const Exception& xcpt ) {
+        fprintf( stderr, "? %s\n", xcpt.what() );
+        return EXIT_FAILURE;
+    }
+
+    if ( prog.getLineInfoCount() != (size_t) nLines ) {
+        fprintf( stderr, "line count mismatch\n" );
+        return EXIT_FAILURE;
+    }
+
+    delete [] bodyLen;
+    delete [] body;
+    delete [] src;
+
+    return EXIT_SUCCESS;
+}
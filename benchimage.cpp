@@ -0,0 +1,122 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+#include "program.h"
+#include "exception.h"
+#include "benchsource.h"
+#include "detokenizer.h"
+
+#define BENCHLINES      200000
+#define BENCHREPEAT     10
+
+static void enterText( Program& prog, const char* text ) {
+    Tokenizer t( (const uint8_t*) text, strlen( text ) );
+    if ( t.tokenize() != T_EOL ) {
+        throw Exception( "tokenize error: %s", text );
+    }
+    prog.enterLine( t );
+}
+
+int main( int argc, char** argv ) {
+
+    int nLines = BENCHLINES;
+    if ( argc > 1 ) nLines = atoi( argv[1] );
+    if ( nLines <= 0 ) nLines = BENCHLINES;
+
+    const char* srcName = "benchimage.bas";
+    const char* imgName = "benchimage.img";
+    const char* txtName = "benchimage.txt";
+
+    size_t len = 0;
+    char*  src = genBenchSource( len, nLines );
+    FILE*  fp  = fopen( srcName, "wb" );
+    if ( fp == 0 || fwrite( src, 1U, len, fp ) != len || fclose( fp ) ) {
+        fprintf( stderr, "? cannot write %s\n", srcName );
+        return EXIT_FAILURE;
+    }
+    delete [] src;
+
+    int rc = EXIT_SUCCESS;
+    try {
+        Program prog;
+        double ti0 = getTime();
+        prog.load( srcName );
+        double ti1 = getTime();
+        printf( "source load   %10.3f ms, %lu bytes source, %lu lines\n",
+            ( ti1 - ti0 ) * 1000.0, (unsigned long) len, 
+            (unsigned long) prog.getLineInfoCount() );
+        prog.save( imgName );
+        double ti2 = getTime();
+        printf( "image save    %10.3f ms, %lu bytes code\n",
+            ( ti2 - ti1 ) * 1000.0, (unsigned long) prog.getSize() );
+
+        // ASCII save: one Detokenizer and printf per line, as LIST did,
+        // against the streaming writer
+        fp = fopen( txtName, "wb" );
+        if ( fp == 0 ) throw Exception( "cannot write %s", txtName );
+        double ti3 = getTime();
+        for ( size_t pos=0; pos < prog.getLineInfoCount(); ++pos ) {
+            const LineInfo& li = prog.getLineInfoAt( pos );
+            prog.setReadPos( li.offset );
+            Detokenizer d( prog.readBlock( li.length ) );
+            fprintf( fp, "%s\n", d.detokenize() );
+        }
+        fclose( fp );
+        double ti4 = getTime();
+        prog.saveText( txtName );
+        double ti5 = getTime();
+        printf( "text per line %10.3f ms\n", ( ti4 - ti3 ) * 1000.0 );
+        printf( "text save     %10.3f ms, %.0f MB/s\n", ( ti5 - ti4 ) * 1000.0,
+            len / ( ti5 - ti4 ) / 1048576.0 );
+
+        // image loads, each into a fresh program (map, validate, attach)
+        double tLoad = 0.0, tEdit = 0.0;
+        for ( int i=0; i < BENCHREPEAT; ++i ) {
+            Program img;
+            double t0 = getTime();
+            img.load( imgName );
+            double t1 = getTime();
+            if ( img.getLineInfoCount() != prog.getLineInfoCount() ||
+                img.getSize() != prog.getSize() ) {
+                throw Exception( "image mismatch" );
+            }
+            // the first change copies the program out of the image
+            enterText( img, "5 PRINT \"first edit\"" );
+            double t2 = getTime();
+            tLoad += t1 - t0; tEdit += t2 - t1;
+        }
+        printf( "image load    %10.3f ms (mapped, validated)\n",
+            tLoad * 1000.0 / BENCHREPEAT );
+        printf( "first edit    %10.3f ms (copy from image)\n",
+            tEdit * 1000.0 / BENCHREPEAT );
+    }
+    catch ( const Exception& xcpt ) {
+        fprintf( stderr, "? %s\n", xcpt.what() );
+        rc = EXIT_FAILURE;
+    }
+
+    remove( srcName );
+    remove( imgName );
+    remove( txtName );
+
+    return rc;
+}
@@ -0,0 +1,135 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "keywords.h"
+#include "tokens.h"
+
+#define BENCHNAMES      4096
+#define BENCHROUNDS     2000
+
+static uint32_t rndState = UINT32_C(0X87654321);
+
+static uint32_t rnd( uint32_t rng ) {
+    rndState = rndState * UINT32_C(1103515245) + UINT32_C(12345);
+    return ( rndState >> 8U ) % rng;
+}
+
+struct Name {
+    uint8_t text[32];
+    size_t  len;
+};
+
+// the former lookup path: chained hash table plus dynamic_cast
+static uint16_t htLookup( const HashTable& ht, const uint8_t* name, 
+    size_t nameLen ) {
+    HashEntry* ent = ht.find( name, nameLen );
+    if ( ent == 0 ) return KW_NOTFOUND;
+    KW_Hashent* kw = dynamic_cast<KW_Hashent*>( ent );
+    if ( kw == 0 ) return KW_NOTFOUND;
+    return kw->tok;
+}
+
+static void genNames( Name* names, int nNames, const PredefKW* predef,
+    int nKw, int hitPercent ) {
+    static const char alnum[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    for ( int i=0; i < nNames; ++i ) {
+        Name& n = names[i];
+        if ( (int) rnd( 100 ) < hitPercent ) {
+            const char* p = predef[ rnd( nKw ) ].text;
+            n.len = (uint8_t) *p;
+            memcpy( n.text, p + 1, n.len );
+        } else {
+            n.len = 1U + rnd( 12 );
+            for ( size_t j=0; j < n.len; ++j ) {
+                n.text[j] = alnum[ j == 0 ? rnd( 26 ) : rnd( 36 ) ];
+            }
+        }
+    }
+}
+
+static void bench( const char* title, const Name* names, int nNames, 
+    const HashTable& ht ) {
+    Keywords& kw = Keywords::getInstance();
+    unsigned long hits1 = 0, hits2 = 0;
+
+    double ti0 = getTime();
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        for ( int i=0; i < nNames; ++i ) {
+            if ( htLookup( ht, names[i].text, names[i].len ) != KW_NOTFOUND ) 
+                ++hits1;
+        }
+    }
+    double ti1 = getTime();
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        for ( int i=0; i < nNames; ++i ) {
+            if ( kw.lookup( names[i].text, names[i].len ) != KW_NOTFOUND ) 
+                ++hits2;
+        }
+    }
+    double ti2 = getTime();
+
+    if ( hits1 != hits2 ) {
+        fprintf( stderr, "hit count mismatch: %lu vs. %lu\n", hits1, hits2 );
+        exit( EXIT_FAILURE );
+    }
+
+    double n = (double) nNames * BENCHROUNDS;
+    printf( "%-16s HashTable %7.1f ns/lookup  perfect hash %7.1f ns/lookup\n",
+        title, ( ti1 - ti0 ) * 1.0e9 / n, ( ti2 - ti1 ) * 1.0e9 / n );
+}
+
+int main( int argc, char** argv ) {
+
+    const PredefKW* predef = Keywords::getPredef();
+    Keywords&       kw     = Keywords::getInstance();
+
+    HashTable ht;
+    int nKw = 0;
+    for ( ; predef[nKw].text; ++nKw ) {
+        const char* p   = predef[nKw].text;
+        uint8_t     len = (uint8_t) *p++;
+        ht.enter( KW_Hashent::borrow( p, len, 
+            (uint16_t) predef[nKw].tok ) );
+        if ( kw.lookup( (const uint8_t*) p, len ) != 
+            (uint16_t) predef[nKw].tok ) {
+            fprintf( stderr, "keyword '%.*s' not found\n", (int) len, p );
+            return EXIT_FAILURE;
+        }
+    }
+    printf( "%d predefined keywords\n", nKw );
+
+    Name* names = new Name [ BENCHNAMES ];
+
+    genNames( names, BENCHNAMES, predef, nKw, 100 );
+    bench( "100% keywords", names, BENCHNAMES, ht );
+
+    genNames( names, BENCHNAMES, predef, nKw, 20 );
+    bench( "20% keywords", names, BENCHNAMES, ht );
+
+    genNames( names, BENCHNAMES, predef, nKw, 0 );
+    bench( "0% keywords", names, BENCHNAMES, ht );
+
+    delete [] names;
+
+    return EXIT_SUCCESS;
+}
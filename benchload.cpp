@@ -0,0 +1,117 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "program.h"
+#include "exception.h"
+#include "benchsource.h"
+
+#define BENCHLINES      100000
+
+// the interactive path: one Tokenizer per line, copied by enterLine()
+static double loadPerLine( Program& prog, const char* src, size_t len ) {
+    double ti0 = getTime();
+    prog.clear();
+    const char* p = src; const char* end = src + len;
+    while ( p < end ) {
+        const char* eol = (const char*) memchr( p, '\n', end - p );
+        if ( eol == 0 ) eol = end;
+        Tokenizer t( (const uint8_t*) p, eol - p );
+        if ( t.tokenize() != T_EOL ) {
+            throw Exception( "tokenize error: %.*s", (int)( eol - p ), p );
+        }
+        prog.enterLine( t );
+        p = eol + 1;
+    }
+    return getTime() - ti0;
+}
+
+static double loadStreaming( Program& prog, const char* src, size_t len,
+    int nThreads ) {
+    double ti0 = getTime();
+    prog.load( (const uint8_t*) src, len, nThreads );
+    return getTime() - ti0;
+}
+
+// compares the tokenized lines of two programs
+static bool sameProgram( Program& a, Program& b ) {
+    size_t count = a.getLineInfoCount();
+    if ( b.getLineInfoCount() != count ) return false;
+    for ( size_t pos=0; pos < count; ++pos ) {
+        const LineInfo& la = a.getLineInfoAt( pos );
+        const LineInfo& lb = b.getLineInfoAt( pos );
+        if ( la.lineNo != lb.lineNo || la.length != lb.length ) return false;
+        a.setReadPos( la.offset ); b.setReadPos( lb.offset );
+        const uint8_t* pa = a.readBlock( la.length );
+        const uint8_t* pb = b.readBlock( lb.length );
+        if ( pa == 0 || pb == 0 || memcmp( pa, pb, la.length ) ) return false;
+    }
+    return true;
+}
+
+int main( int argc, char** argv ) {
+
+    int nLines = BENCHLINES;
+    if ( argc > 1 ) nLines = atoi( argv[1] );
+    if ( nLines <= 0 ) nLines = BENCHLINES;
+
+    size_t len = 0;
+    char*  src = genBenchSource( len, nLines );
+    printf( "%d lines, %lu bytes of source\n", nLines, (unsigned long) len );
+
+    try {
+        Program prog;
+
+        double t1 = loadPerLine( prog, src, len );
+        size_t n1 = prog.getLineInfoCount();
+        if ( n1 != (size_t) nLines ) {
+            fprintf( stderr, "line count mismatch: %lu vs. %d\n",
+                (unsigned long) n1, nLines );
+            return EXIT_FAILURE;
+        }
+        printf( "per line (enterLine)  %9.2f ms  %10.0f lines/s\n",
+            t1 * 1.0e3, nLines / t1 );
+
+        double t2 = 0;
+        for ( int nThreads=1; nThreads <= 8; nThreads *= 2 ) {
+            Program prog2;
+            double  t = loadStreaming( prog2, src, len, nThreads );
+            if ( !sameProgram( prog, prog2 ) ) {
+                fprintf( stderr, "program mismatch with %d thread(s)\n", 
+                    nThreads );
+                return EXIT_FAILURE;
+            }
+            if ( nThreads == 1 ) t2 = t;
+            printf( "load, %d thread(s)     %9.2f ms  %10.0f lines/s  "
+                "speedup %.2f\n", nThreads, t * 1.0e3, nLines / t, t2 / t );
+        }
+        printf( "(%d processor(s) online)\n", getNumCPUs() );
+    }
+    catch ( const Exception& xcpt ) {
+        fprintf( stderr, "? %s\n", xcpt.what() );
+        return EXIT_FAILURE;
+    }
+
+    delete [] src;
+
+    return EXIT_SUCCESS;
+}
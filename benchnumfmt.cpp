@@ -0,0 +1,116 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+#include "variables.h"
+
+#define BENCHCOUNT      1000000
+
+static uint64_t rndState = UINT64_C(0X9E3779B97F4A7C15);
+
+static uint64_t rnd() {
+    rndState ^= rndState << 13; rndState ^= rndState >> 7; 
+    rndState ^= rndState << 17;
+    return rndState;
+}
+
+int main( int argc, char** argv ) {
+
+    int n = BENCHCOUNT;
+    if ( argc > 1 ) n = atoi( argv[1] );
+    if ( n <= 0 ) n = BENCHCOUNT;
+
+    // integers of all lengths; reals as typed in programs, and random bits
+    int64_t* iv = new int64_t [ n ];
+    double*  rv = new double [ n ];
+    for ( int i=0; i < n; ++i ) {
+        uint64_t r = rnd();
+        iv[i] = (int64_t)( r >> ( r & 63U ) ) * ( ( r & 64U ) ? -1 : 1 );
+        if ( i & 1 ) {
+            rv[i] = (double)( r % 10000000U ) / 1000.0;
+        } else {
+            do { r = rnd(); memcpy( &rv[i], &r, sizeof(double) ); }
+            while ( rv[i] != rv[i] || isinf( rv[i] ) );
+        }
+    }
+
+    // every real must read back as the same value
+    char   buf[FMT_REALSZ+1U];
+    size_t total = 0;
+    for ( int i=0; i < n; ++i ) {
+        size_t len = fmtReal( buf, rv[i] ); buf[len] = '\0';
+        if ( strtod( buf, 0 ) != rv[i] ) {
+            fprintf( stderr, "round trip failed: %s vs. %.17g\n", buf, rv[i] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    // odd indices hold typed-in reals, even ones random bit patterns
+    uint8_t* text; size_t len; bool bFree;
+    double ti0 = getTime();
+    for ( int i=0; i < n; ++i ) {
+        format( text, len, "%" PRId64, iv[i] ); total += len; delete [] text;
+    }
+    double ti1 = getTime();
+    for ( int i=0; i < n; ++i ) total += fmtInt( buf, iv[i] );
+    double ti2 = getTime();
+    for ( int i=1; i < n; i += 2 ) {
+        format( text, len, "%g", rv[i] ); total += len; delete [] text;
+    }
+    double ti3 = getTime();
+    for ( int i=1; i < n; i += 2 ) total += fmtReal( buf, rv[i] );
+    double ti4 = getTime();
+    for ( int i=0; i < n; i += 2 ) {
+        format( text, len, "%.17g", rv[i] ); total += len; delete [] text;
+    }
+    double ti5 = getTime();
+    for ( int i=0; i < n; i += 2 ) total += fmtReal( buf, rv[i] );
+    double ti6 = getTime();
+    IntVal  ival;
+    RealVal rval;
+    for ( int i=0; i < n; ++i ) {
+        ival.value = iv[i];
+        ival.getStrVal( text, len, bFree ); total += len; delete [] text;
+    }
+    double ti7 = getTime();
+    for ( int i=1; i < n; i += 2 ) {
+        rval.value = rv[i];
+        rval.getStrVal( text, len, bFree ); total += len; delete [] text;
+    }
+    double ti8 = getTime();
+
+    double h = n / 2;
+    printf( "int    format %%" PRId64 "     %7.1f ns/number\n", ( ti1 - ti0 ) * 1.0e9 / n );
+    printf( "int    fmtInt          %7.1f ns/number\n", ( ti2 - ti1 ) * 1.0e9 / n );
+    printf( "int    getStrVal       %7.1f ns/number\n", ( ti7 - ti6 ) * 1.0e9 / n );
+    printf( "typed  format %%g       %7.1f ns/number (6 digits only)\n", 
+        ( ti3 - ti2 ) * 1.0e9 / h );
+    printf( "typed  fmtReal         %7.1f ns/number\n", ( ti4 - ti3 ) * 1.0e9 / h );
+    printf( "typed  getStrVal       %7.1f ns/number\n", ( ti8 - ti7 ) * 1.0e9 / h );
+    printf( "bits   format %%.17g    %7.1f ns/number\n", ( ti5 - ti4 ) * 1.0e9 / h );
+    printf( "bits   fmtReal         %7.1f ns/number\n", ( ti6 - ti5 ) * 1.0e9 / h );
+    printf( "(%lu characters)\n", (unsigned long) total );
+
+    delete [] rv;
+    delete [] iv;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "interpreter.h"
+
+#define BENCHLINES      200000
+#define BENCHROUNDS     5
+
+// direct mode commands and program lines, as a script would send them
+static const char* const replLines[] = {
+    "LET A = A + 1",
+    "LET B = A * 2 + 7 : LET C$ = \"TEXT\"",
+    "10 PRINT \"HELLO\"; A",
+    "LET X = (A - B) / 3",
+    "20 LET A = A + 1 : GOTO 10",
+    "LET D$ = C$ + \"MORE\"",
+    0
+};
+
+// tokenizes the lines with a Tokenizer per line, or with one reused one
+static double tokenizeLines( int nLines, int nRepl, bool reuse ) {
+    Tokenizer t( 0, 0 );
+    size_t    sum = 0;
+    double    ti0 = getTime();
+    for ( int i=0; i < nLines; ++i ) {
+        const char* line = replLines[ i % nRepl ];
+        if ( reuse ) {
+            t.reset( (const uint8_t*) line, strlen(line) );
+            t.tokenize();
+            sum += t.getTokBufSz();
+        } else {
+            Tokenizer t2( (const uint8_t*) line, strlen(line) );
+            t2.tokenize();
+            sum += t2.getTokBufSz();
+        }
+    }
+    double dif = getTime() - ti0;
+    if ( sum == 0 ) printf( "?\n" );
+    return dif;
+}
+
+int main( int argc, char** argv ) {
+
+    int nLines = BENCHLINES;
+    if ( argc > 1 ) nLines = atoi( argv[1] );
+    if ( nLines <= 0 ) nLines = BENCHLINES;
+
+    int nRepl = 0;
+    while ( replLines[nRepl] ) ++nRepl;
+
+    Interpreter intp;
+    double best = 0;
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        double ti0 = getTime();
+        try {
+            for ( int i=0; i < nLines; ++i ) {
+                intp.interpretLine( replLines[ i % nRepl ] );
+            }
+        }
+        catch ( const Exception& xcpt ) {
+            fprintf( stderr, "? %s\n", xcpt.what() );
+            return EXIT_FAILURE;
+        }
+        double dif = getTime() - ti0;
+        if ( r == 0 || dif < best ) best = dif;
+    }
+
+    printf( "interpretLine             %10.0f lines/s\n", nLines / best );
+
+    double best1 = 0, best2 = 0;
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        double t1 = tokenizeLines( nLines, nRepl, false );
+        double t2 = tokenizeLines( nLines, nRepl, true );
+        if ( r == 0 || t1 < best1 ) best1 = t1;
+        if ( r == 0 || t2 < best2 ) best2 = t2;
+    }
+    printf( "tokenize, new Tokenizer   %10.0f lines/s\n", nLines / best1 );
+    printf( "tokenize, reset()         %10.0f lines/s\n", nLines / best2 );
+
+    return EXIT_SUCCESS;
+}
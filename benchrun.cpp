@@ -0,0 +1,81 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "interpreter.h"
+
+#define BENCHITERS      100000
+
+// each iteration does 11 jumps: IF..THEN, 5 GOSUBs and 5 RETURNs
+#define JUMPSPERITER    11
+
+static void enter( Interpreter& intp, const char* fmt, ... ) {
+    char    line[256];
+    va_list ap;
+    va_start( ap, fmt );
+    vsnprintf( line, sizeof(line), fmt, ap );
+    va_end( ap );
+    intp.interpretLine( line );
+}
+
+// runs nested GOSUB loops in a program padded with nPad lines between
+// the main loop and the subroutines
+static double runProgram( int nPad, int nIters ) {
+    Interpreter intp;
+    enter( intp, "10 LET I = 0 : LET N = %d", nIters );
+    enter( intp, "20 GOSUB 9000000" );
+    enter( intp, "30 LET I = I + 1" );
+    enter( intp, "40 IF I < N THEN 20" );
+    enter( intp, "50 END" );
+    for ( int i=0; i < nPad; ++i ) {
+        enter( intp, "%d REM padding", 100 + i * 10 );
+    }
+    enter( intp, "9000000 GOSUB 9000100 : GOSUB 9000100 : RETURN" );
+    enter( intp, "9000100 GOSUB 9000200 : RETURN" );
+    enter( intp, "9000200 RETURN" );
+    double ti0 = getTime();
+    enter( intp, "RUN" );
+    return getTime() - ti0;
+}
+
+int main( int argc, char** argv ) {
+
+    int nIters = BENCHITERS;
+    if ( argc > 1 ) nIters = atoi( argv[1] );
+    if ( nIters <= 0 ) nIters = BENCHITERS;
+
+    static const int pads[] = { 0, 1000, 10000, 100000, -1 };
+    try {
+        for ( int i=0; pads[i] >= 0; ++i ) {
+            double dif = runProgram( pads[i], nIters );
+            printf( "%7d lines  %10.0f iterations/s  %10.0f jumps/s\n", 
+                pads[i] + 8, nIters / dif, 
+                (double) nIters * JUMPSPERITER / dif );
+        }
+    }
+    catch ( const Exception& xcpt ) {
+        fprintf( stderr, "? %s\n", xcpt.what() );
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
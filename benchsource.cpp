@@ -0,0 +1,124 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "benchsource.h"
+
+static uint32_t rndState;
+
+static uint32_t rnd( uint32_t rng ) {
+    rndState = rndState * UINT32_C(1103515245) + UINT32_C(12345);
+    return ( rndState >> 8U ) % rng;
+}
+
+static const char* const identNames[] = {
+    "A", "I%", "COUNTER", "total", "NAME$", "Value2", "x", "ResultBuffer$",
+    "idx%", "LOOPINDEX", "Z9", "customerName$", 0
+};
+
+static const char* randIdent() {
+    static int n = 0;
+    if ( n == 0 ) while ( identNames[n] ) ++n;
+    return identNames[ rnd( n ) ];
+}
+
+// generates a typical line of (machine-generated) BASIC code
+static int genCodeLine( char* buf, size_t bufSz, uint32_t lineNo ) {
+    switch ( rnd( 6 ) ) {
+        case 0:
+            return snprintf( buf, bufSz, "%lu LET %s = %s + %u * (%s - %u.%u)\n",
+                (unsigned long) lineNo, randIdent(), randIdent(), rnd( 1000 ), 
+                randIdent(), rnd( 100 ), rnd( 100 ) );
+        case 1:
+            return snprintf( buf, bufSz, "%lu PRINT \"Result: \"; %s, %s : GOTO %u\n",
+                (unsigned long) lineNo, randIdent(), randIdent(), rnd( 60000 ) );
+        case 2:
+            return snprintf( buf, bufSz, "%lu IF %s >= %u AND %s <> $%X THEN %u\n",
+                (unsigned long) lineNo, randIdent(), rnd( 5000 ), randIdent(), 
+                rnd( 65536 ), rnd( 60000 ) );
+        case 3:
+            return snprintf( buf, bufSz, "%lu %s = LEFT$(%s, %u) + MID$(%s, %u, %u)\n",
+                (unsigned long) lineNo, randIdent(), randIdent(), rnd( 10 ), 
+                randIdent(), rnd( 10 ), rnd( 10 ) );
+        case 4:
+            return snprintf( buf, bufSz, "%lu FOR %s = 1 TO %u : GOSUB %u : NEXT %s\n",
+                (unsigned long) lineNo, randIdent(), rnd( 1000 ), rnd( 60000 ), 
+                randIdent() );
+        default:
+            return snprintf( buf, bufSz, "%lu DATA %u, %u.%u, %u, %u, %u\n",
+                (unsigned long) lineNo, rnd( 100000 ), rnd( 1000 ), rnd( 1000 ),
+                rnd( 256 ), rnd( 65536 ), rnd( 10 ) );
+    }
+}
+
+// generates a DATA line full of numeric literals in all bases
+static int genDataLine( char* buf, size_t bufSz, uint32_t lineNo ) {
+    return snprintf( buf, bufSz, "%lu DATA %u.%03u, -%u.%uE-%u, $%X, "
+        "%u, $%X.%XP%u, %%%u%u%u%u.1, @%o, %u.%u, %uE%u\n",
+        (unsigned long) lineNo, rnd( 100000 ), rnd( 1000 ), rnd( 10 ), 
+        rnd( 100000 ), rnd( 30 ), rnd( 65536 ), rnd( 1000000 ), rnd( 4096 ),
+        rnd( 256 ), rnd( 8 ), rnd( 2 ), rnd( 2 ), rnd( 2 ), rnd( 2 ),
+        rnd( 4096 ), rnd( 100 ), rnd( 100 ), rnd( 10 ), rnd( 20 ) );
+}
+
+static const char loremText[] = 
+    "THIS ROUTINE COMPUTES THE MONTHLY TOTALS FOR ALL CUSTOMER ACCOUNTS "
+    "AND PRINTS A REPORT. Please enter the account number, then press "
+    "RETURN to continue or ESC to go back to the main menu -- 1983 ";
+
+// generates an indented line of remarks or PRINT statements
+static int genTextLine( char* buf, size_t bufSz, uint32_t lineNo ) {
+    int indent = (int) rnd( 12 ), ofs = (int) rnd( 60 );
+    int len    = 40 + (int) rnd( 120 );
+    switch ( rnd( 3 ) ) {
+        case 0:
+            return snprintf( buf, bufSz, "%lu%*sREM %.*s\n", 
+                (unsigned long) lineNo, indent + 1, "", len, &loremText[ofs] );
+        case 1:
+            return snprintf( buf, bufSz, "%lu%*s' %.*s\n", 
+                (unsigned long) lineNo, indent + 1, "", len, &loremText[ofs] );
+        default:
+            return snprintf( buf, bufSz, "%lu%*sPRINT \"%.*s\";\"%.*s\"\n", 
+                (unsigned long) lineNo, indent + 1, "", len / 2, 
+                &loremText[ofs], len / 2, &loremText[ofs+len/2] );
+    }
+}
+
+char* genBenchSource( size_t& rLen, int nLines, BenchSourceKind kind ) {
+    size_t alloc = (size_t) nLines * ( kind == BS_TEXT ? 256U : 128U );
+    size_t len   = 0;
+    rndState = UINT32_C(0X12345678);
+    char*  src   = new char [ alloc ];
+    for ( int i=0; i < nLines; ++i ) {
+        uint32_t lineNo = (uint32_t)( i+1 ) * 10U;
+        int n;
+        switch ( kind ) {
+            case BS_DATA: n = genDataLine( &src[len], alloc - len, lineNo ); break;
+            case BS_TEXT: n = genTextLine( &src[len], alloc - len, lineNo ); break;
+            default:      n = genCodeLine( &src[len], alloc - len, lineNo ); break;
+        }
+        if ( n < 0 || (size_t) n >= alloc - len ) break;
+        len += (size_t) n;
+    }
+    rLen = len;
+    return src;
+}
@@ -0,0 +1,41 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#ifndef BENCHSOURCE_H
+#define BENCHSOURCE_H   1
+
+#ifndef TYPES_H
+#include "types.h"
+#endif
+
+enum BenchSourceKind {
+    BS_CODE,    // a mix of typical statements
+    BS_DATA,    // DATA statements with numeric literals
+    BS_TEXT,    // indented remarks and long string literals
+};
+
+// generates nLines lines of numbered BASIC source text (line numbers
+// 10, 20, ...), the same text on every call. Delete with delete [].
+char* genBenchSource( size_t& rLen, int nLines, BenchSourceKind kind = BS_CODE );
+
+#endif
@@ -0,0 +1,157 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "tokenizer.h"
+#include "tokenscanner.h"
+#include "tokenstream.h"
+#include "benchsource.h"
+
+#define BENCHLINES      20000
+#define BENCHROUNDS     5
+#define BENCHPASSES     20
+
+// reads every token the way the evaluator does; returns a checksum
+static double walkBytes( const uint8_t* toks, size_t nLines ) {
+    TokenScanner scan( toks );
+    double sum = 0;
+    for ( size_t n=0; n < nLines; ) {
+        uint16_t tok = scan.tokType();
+        if ( tok == T_NUMLIT || tok == T_SBI ) {
+            if ( scan.isInt() ) { int64_t v; scan.getInt( v ); sum += v; }
+            else { double v; scan.getReal( v ); sum += v; }
+        } else if ( tok == T_IDENT || tok == T_STRLIT ) {
+            const uint8_t* text; uint8_t len;
+            scan.getText( text, len ); sum += len;
+        } else if ( tok == T_LINENO ) {
+            uint32_t lineNo; scan.getLineNo( lineNo ); sum += lineNo;
+        }
+        if ( !scan.skipTok() ) { scan.setPos( scan.getPos() + 1 ); ++n; }
+    }
+    return sum;
+}
+
+// tokType() and skipTok() only, as in skipping over statements
+static double walkSkip( const uint8_t* toks, size_t nLines ) {
+    TokenScanner scan( toks );
+    double sum = 0;
+    for ( size_t n=0; n < nLines; ) {
+        sum += scan.tokType();
+        if ( !scan.skipTok() ) { scan.setPos( scan.getPos() + 1 ); ++n; }
+    }
+    return sum;
+}
+
+static double walkStream( const TokenStream& stream ) {
+    StreamScanner scan( stream.getAt( 0 ) );
+    const XTok* end = stream.getAt( 0 ) + stream.getCount();
+    double sum = 0;
+    while ( scan.getPos() < end ) {
+        uint16_t tok = scan.tokType();
+        if ( tok == T_NUMLIT || tok == T_SBI ) {
+            if ( scan.isInt() ) { int64_t v; scan.getInt( v ); sum += v; }
+            else { double v; scan.getReal( v ); sum += v; }
+        } else if ( tok == T_IDENT || tok == T_STRLIT ) {
+            const uint8_t* text; uint8_t len;
+            scan.getText( text, len ); sum += len;
+        } else if ( tok == T_LINENO ) {
+            uint32_t lineNo; scan.getLineNo( lineNo ); sum += lineNo;
+        }
+        if ( !scan.skipTok() ) scan.setPos( scan.getPos() + 1 );
+    }
+    return sum;
+}
+
+int main( int argc, char** argv ) {
+
+    int nLines = BENCHLINES;
+    if ( argc > 1 ) nLines = atoi( argv[1] );
+    if ( nLines <= 0 ) nLines = BENCHLINES;
+
+    size_t len = 0;
+    char*  src = genBenchSource( len, nLines );
+    ByteBuffer toks( len * 2U );
+    const char* p = src; const char* end = src + len;
+    while ( p < end ) {
+        const char* eol = (const char*) memchr( p, '\n', end - p );
+        if ( eol == 0 ) eol = end;
+        Tokenizer t( (const uint8_t*) p, eol - p );
+        if ( t.tokenize( toks ) != T_EOL ) {
+            fprintf( stderr, "tokenize error: %.*s\n", (int)( eol - p ), p );
+            return EXIT_FAILURE;
+        }
+        p = eol + 1;
+    }
+    delete [] src;
+
+    TokenStream stream;
+    double bestDec = 0, bestBytes = 0, bestStream = 0, bestSkip = 0;
+    double sum1 = 0, sum2 = 0, sum3 = 0;
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        double ti0 = getTime();
+        stream.clear();
+        const uint8_t* pos = toks.getBaseAddr();
+        for ( int i=0; i < nLines; ++i ) {
+            size_t n = stream.getCount();
+            if ( !stream.append( pos ) ) {
+                fprintf( stderr, "decode error\n" );
+                return EXIT_FAILURE;
+            }
+            for ( ; n < stream.getCount(); ++n ) pos += stream.getAt( n )->size;
+        }
+        double ti1 = getTime();
+        for ( int i=0; i < BENCHPASSES; ++i ) {
+            sum1 += walkBytes( toks.getBaseAddr(), nLines );
+        }
+        double ti2 = getTime();
+        for ( int i=0; i < BENCHPASSES; ++i ) {
+            sum2 += walkStream( stream );
+        }
+        double ti3 = getTime();
+        for ( int i=0; i < BENCHPASSES; ++i ) {
+            sum3 += walkSkip( toks.getBaseAddr(), nLines );
+        }
+        double ti4 = getTime();
+        if ( r == 0 || ti1 - ti0 < bestDec    ) bestDec    = ti1 - ti0;
+        if ( r == 0 || ti2 - ti1 < bestBytes  ) bestBytes  = ti2 - ti1;
+        if ( r == 0 || ti3 - ti2 < bestStream ) bestStream = ti3 - ti2;
+        if ( r == 0 || ti4 - ti3 < bestSkip   ) bestSkip   = ti4 - ti3;
+    }
+    if ( sum1 != sum2 ) {
+        fprintf( stderr, "checksum mismatch: %g vs %g\n", sum1, sum2 );
+        return EXIT_FAILURE;
+    }
+
+    double nTok = (double) stream.getCount();
+    printf( "%d lines, %lu bytes tokenized, %.0f tokens\n", nLines, 
+        (unsigned long) toks.getWritePos(), nTok );
+    printf( "decode                    %12.0f tokens/s\n", nTok / bestDec );
+    printf( "walk, TokenScanner        %12.0f tokens/s\n", 
+        nTok * BENCHPASSES / bestBytes );
+    printf( "walk, StreamScanner       %12.0f tokens/s\n", 
+        nTok * BENCHPASSES / bestStream );
+    printf( "skip, TokenScanner        %12.0f tokens/s  %8.1f MB/s\n", 
+        nTok * BENCHPASSES / bestSkip, 
+        (double) toks.getWritePos() * BENCHPASSES / bestSkip / 1.0e6 );
+
+    return EXIT_SUCCESS;
+}
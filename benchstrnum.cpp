@@ -0,0 +1,112 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "variables.h"
+#include "tokenizer.h"
+
+#define BENCHROUNDS     200000
+
+static const char* const samples[] = {
+    "0", "1", "42", "-17", "+3", "65535", "1234567890", "  99 ", "12 apples",
+    "3.14159", "-0.5", ".25", "2.5E3", "1E-5", "-6.02E23", "123456.789",
+    "$FF", "$-1", "%1011", "@777", "$1.8P1", "&HFFFF", "&B101", "abc", "",
+    0
+};
+
+// the former conversion: a Tokenizer (with its token buffer) per call
+static double oldStrToReal( const uint8_t* ptr, size_t len ) {
+    Tokenizer t( ptr, len );
+    uint16_t tok = t.nextTok(); bool minus = false;
+    if ( tok == T_MINUS ) {
+        minus = true;
+        tok   = t.nextTok();
+    } else if ( tok == T_PLUS ) {
+        tok   = t.nextTok();
+    }
+    double value = 0;
+    if ( tok == T_NUMLIT ) {
+        if ( t.numIsInt() ) {
+            value = (double) t.numIVal();
+        } else {
+            value = t.numRVal();
+        }
+        if ( minus ) value = -value;
+    }
+    return value;
+}
+
+int main( int argc, char** argv ) {
+
+    int nSamples = 0;
+    while ( samples[nSamples] ) ++nSamples;
+
+    StrVal** sv = new StrVal* [ nSamples ];
+    for ( int i=0; i < nSamples; ++i ) {
+        sv[i] = new StrVal( (const uint8_t*) samples[i], strlen(samples[i]),
+            false );
+        double v1 = oldStrToReal( sv[i]->text, sv[i]->len );
+        double v2 = sv[i]->getRealVal();
+        // &H etc. were not understood before
+        if ( v1 != v2 && samples[i][0] != '&' ) {
+            fprintf( stderr, "'%s': %g vs. %g\n", samples[i], v1, v2 );
+            return EXIT_FAILURE;
+        }
+    }
+
+    double sum1 = 0, sum2 = 0, sum3 = 0;
+    double ti0 = getTime();
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        for ( int i=0; i < nSamples; ++i ) {
+            sum1 += oldStrToReal( sv[i]->text, sv[i]->len );
+        }
+    }
+    double ti1 = getTime();
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        for ( int i=0; i < nSamples; ++i ) {
+            sum2 += sv[i]->getRealVal();
+        }
+    }
+    double ti2 = getTime();
+    IntVal iv;
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        for ( int i=0; i < nSamples; ++i ) {
+            iv.setStrVal( sv[i]->text, sv[i]->len, false );
+            sum3 += (double) iv.value;
+        }
+    }
+    double ti3 = getTime();
+
+    double n = (double) nSamples * BENCHROUNDS;
+    printf( "Tokenizer per conversion  %7.1f ns/conversion\n", 
+        ( ti1 - ti0 ) * 1.0e9 / n );
+    printf( "StrVal::getRealVal        %7.1f ns/conversion\n", 
+        ( ti2 - ti1 ) * 1.0e9 / n );
+    printf( "IntVal::setStrVal         %7.1f ns/conversion\n", 
+        ( ti3 - ti2 ) * 1.0e9 / n );
+    printf( "(checksums %g %g %g)\n", sum1, sum2, sum3 );
+
+    for ( int i=0; i < nSamples; ++i ) delete sv[i];
+    delete [] sv;
+
+    return EXIT_SUCCESS;
+}
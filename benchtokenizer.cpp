@@ -0,0 +1,99 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "tokenizer.h"
+#include "benchsource.h"
+
+#define BENCHLINES      200000
+#define BENCHROUNDS     5
+
+static void bench( const char* title, const char* src, size_t len, bool full ) {
+    double best = 0; unsigned long nTok = 0;
+    for ( int r=0; r < BENCHROUNDS; ++r ) {
+        const char* p = src; const char* end = src + len;
+        nTok = 0;
+        double ti0 = getTime();
+        while ( p < end ) {
+            const char* eol = (const char*) memchr( p, '\n', end - p );
+            if ( eol == 0 ) eol = end;
+            Tokenizer t( (const uint8_t*) p, eol - p );
+            if ( full ) {
+                uint16_t tok = t.tokenize();
+                if ( tok != T_EOL ) {
+                    fprintf( stderr, "tokenize error %u: %.*s\n", tok, 
+                        (int)( eol - p ), p );
+                    exit( EXIT_FAILURE );
+                }
+                nTok += t.getTokBufSz();
+            } else {
+                for (;;) {
+                    uint16_t tok = t.nextTok();
+                    if ( tok == T_EOL || tok >= UINT16_C(0XFF00) ) break;
+                    ++nTok;
+                }
+            }
+            p = eol + 1;
+        }
+        double dif = getTime() - ti0;
+        if ( r == 0 || dif < best ) best = dif;
+    }
+    printf( "%-24s %8.1f MB/s  %12.0f %s/s\n", title, 
+        (double) len / best / 1.0e6, (double) nTok / best, 
+        full ? "bytes" : "tokens" );
+}
+
+int main( int argc, char** argv ) {
+
+    int nLines = BENCHLINES;
+    if ( argc > 1 ) nLines = atoi( argv[1] );
+    if ( nLines <= 0 ) nLines = BENCHLINES;
+
+    size_t len = 0;
+    char*  src = genBenchSource( len, nLines );
+    printf( "%d lines, %lu bytes of source\n", nLines, (unsigned long) len );
+
+    bench( "nextTok (code)", src, len, false );
+    bench( "tokenize (code)", src, len, true );
+
+    delete [] src;
+
+    src = genBenchSource( len, nLines, BS_DATA );
+    printf( "%d lines, %lu bytes of DATA statements\n", nLines, 
+        (unsigned long) len );
+
+    bench( "nextTok (DATA)", src, len, false );
+    bench( "tokenize (DATA)", src, len, true );
+
+    delete [] src;
+
+    src = genBenchSource( len, nLines, BS_TEXT );
+    printf( "%d lines, %lu bytes of remarks and strings\n", nLines, 
+        (unsigned long) len );
+
+    bench( "nextTok (text)", src, len, false );
+    bench( "tokenize (text)", src, len, true );
+
+    delete [] src;
+
+    return EXIT_SUCCESS;
+}
@@ -33,99 +33,23 @@ ByteBuffer::~ByteBuffer() {
     baseAddr = 0; bufSize = bufFill = readPos = 0; freeMem = false;
 }
 
-bool ByteBuffer::readToken( uint16_t& rOut ) {
-    uint8_t hi, lo;
-    if ( !readByte( hi ) ) return false;
-    if ( !readByte( lo ) ) return false;
-    rOut = ( ((uint16_t)hi) << UINT8_C(8) ) | lo;
-    return true;
-}
-
-bool ByteBuffer::writeToken( uint16_t inp ) {
-    uint8_t hi = (uint8_t)( inp >> UINT8_C(8) );
-    uint8_t lo = (uint8_t)  inp;
-    if ( !writeByte( hi ) ) return false;
-    if ( !writeByte( lo ) ) return false;
-    return true;
-}
-
-bool ByteBuffer::readLineNo( uint32_t& rOut ) {
-    uint8_t hi, mid, lo;
-    if ( !readByte( hi  ) ) return false;
-    if ( !readByte( mid ) ) return false;
-    if ( !readByte( lo  ) ) return false;
-    rOut = ( ((uint32_t)hi) << UINT8_C(16) ) | ( ((uint16_t)mid) << UINT8_C(8) ) | lo;
-    return true;
-}
-
-bool ByteBuffer::writeLineNo( uint32_t inp ) {
-    uint8_t hi  = (uint8_t)( inp >> UINT8_C(16) );
-    uint8_t mid = (uint8_t)( inp >> UINT8_C( 8) );
-    uint8_t lo  = (uint8_t)  inp;
-    if ( !writeByte( hi  ) ) return false;
-    if ( !writeByte( mid ) ) return false;
-    if ( !writeByte( lo  ) ) return false;
-    return true;
-}
-
-bool ByteBuffer::readDWord( uint32_t& rOut ) {
-    uint16_t hi, lo;
-    if ( !readWord( hi ) ) return false;
-    if ( !readWord( lo ) ) return false;
-    rOut = ( ((uint32_t)hi) << UINT8_C(16) ) | lo;
-    return true;
-}
-
-bool ByteBuffer::writeDWord( uint32_t inp ) {
-    uint16_t hi = (uint16_t)( inp >> UINT8_C(16) );
-    uint16_t lo = (uint16_t)  inp;
-    if ( !writeWord( hi ) ) return false;
-    if ( !writeWord( lo ) ) return false;
-    return true;
-}
-
-bool ByteBuffer::readReal32( float& rOut ) {
-    U_IntReal32 ir;
-    if ( !readDWord( ir.ival ) ) return false;
-    rOut = ir.rval;
-    return true;
-}
-
-bool ByteBuffer::writeReal32( float inp ) {
-    U_IntReal32 ir;
-    ir.rval = inp;
-    if ( !writeDWord( ir.ival ) ) return false;
-    return true;
-}
-
-bool ByteBuffer::readQWord( uint64_t& rOut ) {
-    uint32_t hi, lo;
-    if ( !readDWord( hi ) ) return false;
-    if ( !readDWord( lo ) ) return false;
-    rOut = ( ((uint64_t)hi) << UINT8_C(32) ) | lo;
-    return true;
-}
-
-bool ByteBuffer::writeQWord( uint64_t inp ) {
-    uint32_t hi = (uint32_t)( inp >> UINT8_C(32) );
-    uint32_t lo = (uint32_t)  inp;
-    if ( !writeDWord( hi ) ) return false;
-    if ( !writeDWord( lo ) ) return false;
-    return true;
-}
-
-bool ByteBuffer::readReal64( double& rOut ) {
-    U_IntReal64 ir;
-    if ( !readQWord( ir.ival ) ) return false;
-    rOut = ir.rval;
-    return true;
+void ByteBuffer::attach( uint8_t* baseAddr_, size_t fill ) {
+    if ( freeMem ) delete [] baseAddr;
+    baseAddr = baseAddr_; bufSize = bufFill = fill; readPos = 0;
+    freeMem  = false;
 }
 
-bool ByteBuffer::writeReal64( double inp ) {
-    U_IntReal64 ir;
-    ir.rval = inp;
-    if ( !writeQWord( ir.ival ) ) return false;
-    return true;
+void ByteBuffer::own( size_t minSize, bool keep ) {
+    if ( freeMem ) return;
+    if ( !keep ) bufFill = 0;
+    size_t newSize = bufFill * 2U;
+    if ( newSize < minSize ) newSize = minSize;
+    if ( newSize == 0 ) newSize = 1U;
+    uint8_t* newBuf = new uint8_t [ newSize ];
+    if ( bufFill ) memcpy( newBuf, baseAddr, bufFill );
+    baseAddr = newBuf; bufSize = newSize;
+    if ( readPos > bufFill ) readPos = bufFill;
+    freeMem  = true;
 }
 
 bool ByteBuffer::autoScale( size_t size ) {
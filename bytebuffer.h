@@ -50,6 +50,16 @@ public:
     ByteBuffer( uint8_t* baseAddr_, size_t bufSize_, size_t bufFill_ );
     virtual ~ByteBuffer();
 
+    // uses fill bytes of external, possibly read-only memory. All 
+    // writes fail until own() is called.
+    void attach( uint8_t* baseAddr_, size_t fill );
+
+    // switches from external memory to an own buffer of at least 
+    // minSize bytes, copying the contents if keep is true
+    void own( size_t minSize, bool keep = true );
+
+    inline bool isOwned() const { return freeMem; }
+
     inline void setMemMgr( BBMemMan& mgr ) { memMgr = &mgr; }
     inline void clrMemMgr() { memMgr = 0; }
 
@@ -83,26 +93,152 @@ public:
     bool readBlock( void* target, size_t size );
     bool writeBlock( const void* source, size_t size );
 
-    bool readToken( uint16_t& rOut );
-    bool writeToken( uint16_t inp );
+    // makes room for size more bytes, for the put*() methods below
+    inline bool reserve( size_t size ) {
+        if ( bufFill + size > bufSize ) return autoScale( size );
+        return true;
+    }
+
+    inline size_t readAvail() const {
+        return readPos < bufFill ? bufFill - readPos : 0;
+    }
+
+    // multi-byte values are stored big-endian. The read*() and write*()
+    // methods check the bounds once and do not move on failure.
+
+    inline bool readToken( uint16_t& rOut ) {
+        if ( readPos + 2U > bufFill ) return false;
+        rOut = fetchWord();
+        return true;
+    }
+
+    inline bool writeToken( uint16_t inp ) {
+        if ( !reserve( 2U ) ) return false;
+        putWord( inp );
+        return true;
+    }
 
     inline bool readWord( uint16_t& rOut ) { return readToken( rOut ); }
     inline bool writeWord( uint16_t inp ) { return writeToken( inp ); }
 
-    bool readLineNo( uint32_t& rOut ); // 24 bit
-    bool writeLineNo( uint32_t inp );  // 24 bit
+    inline bool readLineNo( uint32_t& rOut ) { // 24 bit
+        if ( readPos + 3U > bufFill ) return false;
+        rOut = fetchLineNo();
+        return true;
+    }
+
+    inline bool writeLineNo( uint32_t inp ) {  // 24 bit
+        if ( !reserve( 3U ) ) return false;
+        putLineNo( inp );
+        return true;
+    }
+
+    inline bool readDWord( uint32_t& rOut ) {
+        if ( readPos + 4U > bufFill ) return false;
+        rOut = fetchDWord();
+        return true;
+    }
+
+    inline bool writeDWord( uint32_t inp ) {
+        if ( !reserve( 4U ) ) return false;
+        putDWord( inp );
+        return true;
+    }
+
+    inline bool readReal32( float& rOut ) {
+        if ( readPos + 4U > bufFill ) return false;
+        rOut = fetchReal32();
+        return true;
+    }
+
+    inline bool writeReal32( float inp ) {
+        if ( !reserve( 4U ) ) return false;
+        putReal32( inp );
+        return true;
+    }
+
+    inline bool readQWord( uint64_t& rOut ) {
+        if ( readPos + 8U > bufFill ) return false;
+        rOut = fetchQWord();
+        return true;
+    }
+
+    inline bool writeQWord( uint64_t inp ) {
+        if ( !reserve( 8U ) ) return false;
+        putQWord( inp );
+        return true;
+    }
+
+    inline bool readReal64( double& rOut ) {
+        if ( readPos + 8U > bufFill ) return false;
+        rOut = fetchReal64();
+        return true;
+    }
+
+    inline bool writeReal64( double inp ) {
+        if ( !reserve( 8U ) ) return false;
+        putReal64( inp );
+        return true;
+    }
+
+    // unchecked variants: the caller guarantees the space, by reserve()
+    // for put*(), or by readAvail() for fetch*()
+
+    inline void putByte( uint8_t inp ) { baseAddr[bufFill++] = inp; }
+
+    inline void putWord( uint16_t inp ) {
+        storeBE16( &baseAddr[bufFill], inp ); bufFill += 2U;
+    }
+
+    inline void putLineNo( uint32_t inp ) {
+        storeBE24( &baseAddr[bufFill], inp ); bufFill += 3U;
+    }
+
+    inline void putDWord( uint32_t inp ) {
+        storeBE32( &baseAddr[bufFill], inp ); bufFill += 4U;
+    }
+
+    inline void putQWord( uint64_t inp ) {
+        storeBE64( &baseAddr[bufFill], inp ); bufFill += 8U;
+    }
 
-    bool readDWord( uint32_t& rOut );
-    bool writeDWord( uint32_t inp );
+    inline void putReal32( float inp ) {
+        U_IntReal32 ir; ir.rval = inp; putDWord( ir.ival );
+    }
 
-    bool readReal32( float& rOut );
-    bool writeReal32( float inp );
+    inline void putReal64( double inp ) {
+        U_IntReal64 ir; ir.rval = inp; putQWord( ir.ival );
+    }
 
-    bool readQWord( uint64_t& rOut );
-    bool writeQWord( uint64_t inp );
+    inline void putBlock( const void* source, size_t size ) {
+        memcpy( &baseAddr[bufFill], source, size ); bufFill += size;
+    }
 
-    bool readReal64( double& rOut );
-    bool writeReal64( double inp );
+    inline uint8_t fetchByte() { return baseAddr[readPos++]; }
+
+    inline uint16_t fetchWord() {
+        uint16_t v = loadBE16( &baseAddr[readPos] ); readPos += 2U; return v;
+    }
+
+    inline uint32_t fetchLineNo() {
+        uint32_t v = loadBE24( &baseAddr[readPos] ); readPos += 3U; return v;
+    }
+
+    inline uint32_t fetchDWord() {
+        uint32_t v = loadBE32( &baseAddr[readPos] ); readPos += 4U; return v;
+    }
+
+    inline uint64_t fetchQWord() {
+        uint64_t v = loadBE64( &baseAddr[readPos] ); readPos += 8U; return v;
+    }
+
+    inline float fetchReal32() {
+        U_IntReal32 ir; ir.ival = fetchDWord(); return ir.rval;
+    }
+
+    inline double fetchReal64() {
+        U_IntReal64 ir; ir.ival = fetchQWord(); return ir.rval;
+    }
     
 };
 
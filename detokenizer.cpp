@@ -28,71 +28,115 @@ Detokenizer::Detokenizer( const uint8_t* pos ) : scan(pos), buf(DETOK_BUFSZ) {}
 Detokenizer::~Detokenizer() {}
 
 const char* Detokenizer::detokenize() {
+    buf.setWritePos( 0 );
+    if ( !detokenize( scan.getPos(), buf ) ) return 0;
+    if ( !buf.writeByte(0) ) return 0;
+    return (const char*) buf.getBaseAddr();
+}
+
+bool Detokenizer::detokenize( const uint8_t* line, ByteBuffer& out ) {
+
+    TokenScanner scan( line );
+    Keywords&    kw = Keywords::getInstance();
+
+    // a label first on the line is a definition ("name:"), otherwise 
+    // a jump target
+    bool lineStart = true, first = true;
 
     for (;;) {
         uint16_t tok = scan.tokType();
         if ( tok == T_EOL ) break;
 
-        if ( !buf.writeByte(UINT8_C(32)) ) return 0;
+        // room for the longest token text, so that put*() can be used
+        if ( !out.reserve( DETOK_MAXTOK ) ) return false;
+        out.putByte( UINT8_C(32) );
 
         switch ( tok ) {
             uint32_t lineNo; const uint8_t* text; uint8_t len; double val;
-            const char* text2; int64_t ival; uint8_t* text3; size_t len3;
+            const char* text2; size_t len2; int64_t ival; char num[FMT_REALSZ];
             case T_LINENO:
-                if ( !scan.getLineNo( lineNo ) ) return 0;
-                format( text3, len3, "%" PRIu32, lineNo );
-                if ( !buf.writeBlock( text3, len3 ) ) return 0;
-                delete [] text3;
+                if ( !scan.getLineNo( lineNo ) ) return false;
+                out.putBlock( num, fmtUInt( num, lineNo ) );
                 break;
             case T_IDENT: 
-                if ( !scan.getText( text, len ) ) return 0;
-                if ( !buf.writeBlock( text, len ) ) return 0;
+                if ( !scan.getText( text, len ) ) return false;
+                out.putBlock( text, len );
                 break;
             case T_STRLIT: 
-                if ( !buf.writeByte(UINT8_C(34)) ) return 0;
-                if ( !scan.getText( text, len ) ) return 0;
-                if ( !buf.writeBlock( text, len ) ) return 0;
-                if ( !buf.writeByte(UINT8_C(34)) ) return 0;
+                if ( !scan.getText( text, len ) ) return false;
+                out.putByte( UINT8_C(34) );
+                out.putBlock( text, len );
+                out.putByte( UINT8_C(34) );
                 break;
             case T_LABEL:
-                if ( !scan.getText( text, len ) ) return 0;
-                if ( !buf.writeBlock( text, len ) ) return 0;
-                if ( !buf.writeByte(UINT8_C(58)) ) return 0;
+                if ( !scan.getText( text, len ) ) return false;
+                out.putBlock( text, len );
+                if ( lineStart ) out.putByte( UINT8_C(58) );
                 break;
             case T_NUMLIT: case T_SBI:
                 if ( scan.isInt() ) {
-                    if ( !scan.getInt( ival ) ) return 0;
-                    format( text3, len3, "%" PRId64, ival );
+                    if ( !scan.getInt( ival ) ) return false;
+                    out.putBlock( num, fmtInt( num, ival ) );
                 } else {
-                    if ( !scan.getReal( val ) ) return 0;
-                    format( text3, len3, "%g", val );
+                    if ( !scan.getReal( val ) ) return false;
+                    // an integral real gets a point, or it would come 
+                    // back from the tokenizer as an integer
+                    size_t n = fmtReal( num, val ), i = 0;
+                    if ( num[0] == '-' ) ++i;
+                    while ( i < n && num[i] >= '0' && num[i] <= '9' ) ++i;
+                    if ( i == n ) { num[n++] = '.'; num[n++] = '0'; }
+                    out.putBlock( num, n );
                 }
-                if ( !buf.writeBlock( text3, len3 ) ) return 0;
-                delete [] text3;
+                break;
+            case T_LE: case T_GE: case T_NE:
+                // two-byte operators without a keyword entry
+                out.putBlock( tok == T_LE ? "<=" : ( tok == T_GE ? ">=" : 
+                    "<>" ), 2U );
                 break;
             case T_REM:
-                text2 = Keywords::getInstance().lookup( tok );
-                if ( text2 == 0 ) return 0;
-                if ( !buf.writeBlock( text2, strlen(text2) ) ) return 0;
-                if ( !buf.writeByte(UINT8_C(32)) ) return 0;
-                if ( !scan.getText( text, len ) ) return 0;
-                if ( !buf.writeBlock( text, len ) ) return 0;
+                text2 = kw.lookup( tok, len2 );
+                if ( text2 == 0 || !scan.getText( text, len ) ) return false;
+                out.putBlock( text2, len2 );
+                out.putByte( UINT8_C(32) );
+                out.putBlock( text, len );
                 break;
             default:
                 if ( tok >= UINT16_C(0X0100) || tok == T_PRINT ) {
-                    text2 = Keywords::getInstance().lookup( tok );
-                    if ( text2 == 0 ) return 0;
-                    if ( !buf.writeBlock( text2, strlen(text2) ) ) return 0;
+                    text2 = kw.lookup( tok, len2 );
+                    if ( text2 == 0 ) return false;
+                    out.putBlock( text2, len2 );
                 } else {
-                    if ( !buf.writeByte( (uint8_t) tok ) ) return 0;
+                    out.putByte( (uint8_t) tok );
                 }
                 break;
         }
 
-        if ( !scan.skipTok() ) return 0;
+        lineStart = first && tok == T_LINENO;
+        first     = false;
+        if ( !scan.skipTok() ) return false;
     }
 
-    if ( !buf.writeByte(0) ) return 0;
+    return true;
+}
 
-    return (const char*) buf.getBaseAddr();
-}
\ No newline at end of file
+DetokWriter::DetokWriter( FILE* fp_ ) : fp(fp_), buf(DETOK_WRITESZ + DETOK_BUFSZ),
+    ok(true) {}
+
+DetokWriter::~DetokWriter() {
+    flush();
+}
+
+bool DetokWriter::writeLine( const uint8_t* line ) {
+    if ( !Detokenizer::detokenize( line, buf ) || !buf.writeByte(UINT8_C(10)) ) {
+        return false;
+    }
+    if ( buf.getWritePos() >= DETOK_WRITESZ ) return flush();
+    return ok;
+}
+
+bool DetokWriter::flush() {
+    size_t fill = buf.getWritePos();
+    if ( fill && ok ) ok = fwrite( buf.getBaseAddr(), 1U, fill, fp ) == fill;
+    buf.setWritePos( 0 );
+    return ok;
+}
@@ -38,6 +38,12 @@
 // initial detokenize buffer size
 #define DETOK_BUFSZ     1024U
 
+// longest text of a single token, with the blank before it
+#define DETOK_MAXTOK    300U
+
+// output collected by DetokWriter before it is written
+#define DETOK_WRITESZ   262144U
+
 class Detokenizer : public NonCopyable {
 
     TokenScanner    scan;
@@ -47,8 +53,30 @@ public:
     Detokenizer( const uint8_t* pos );
     virtual ~Detokenizer();
 
+    // returns the line as a C string, valid until the next call
     const char* detokenize();
 
+    // appends the text of a tokenized line to out (no line feed, no
+    // terminating NUL). Does not allocate except to grow out.
+    static bool detokenize( const uint8_t* line, ByteBuffer& out );
+
+};
+
+// writes tokenized lines as text lines to a file, in big chunks
+class DetokWriter : public NonCopyable {
+
+    FILE*           fp;
+    ByteBuffer      buf;
+    bool            ok;     // false after a write error
+
+public:
+    DetokWriter( FILE* fp_ );
+    virtual ~DetokWriter();     // flushes
+
+    // returns false on a bad line or a write error
+    bool writeLine( const uint8_t* line );
+    bool flush();
+
 };
 
 
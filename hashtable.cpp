@@ -23,28 +23,177 @@
 #include "hashtable.h"
 
 HashEntry::HashEntry( const uint8_t* name_, size_t nameLen_ ) {
-    nextHash = 0;
-    name     = new uint8_t [ nameLen_ ];
-    nameLen  = nameLen_;
-    if ( nameLen ) memcpy( name, name_, nameLen );
+    uint8_t* copy = new uint8_t [ nameLen_ ];
+    if ( nameLen_ ) memcpy( copy, name_, nameLen_ );
+    name     = copy;
+    nameLen  = (uint32_t) nameLen_;
+    nameMode = HN_COPY;
+}
+
+HashEntry::HashEntry( const uint8_t* name_, size_t nameLen_, 
+    HashNameMode mode, size_t objSize ) {
+    if ( mode == HN_INLINE ) {
+        uint8_t* copy = (uint8_t*) this + objSize;
+        if ( nameLen_ ) memcpy( copy, name_, nameLen_ );
+        name = copy;
+    } else if ( mode == HN_BORROW ) {
+        name = name_;
+    } else {
+        uint8_t* copy = new uint8_t [ nameLen_ ];
+        if ( nameLen_ ) memcpy( copy, name_, nameLen_ );
+        name = copy;
+    }
+    nameLen  = (uint32_t) nameLen_;
+    nameMode = (uint8_t) mode;
 }
 
 HashEntry::~HashEntry() {
-    if ( nextHash ) { delete nextHash; nextHash = 0; }
-    delete [] name; name = 0; nameLen = 0;
+    if ( nameMode == HN_COPY ) delete [] name;
+    name = 0; nameLen = 0;
+}
+
+void* HashEntry::operator new( size_t size ) {
+    return ::operator new( size );
+}
+
+void* HashEntry::operator new( size_t size, const HashInline& extra ) {
+    if ( extra.arena ) return extra.arena->alloc( size + extra.len );
+    return ::operator new( size + extra.len );
+}
+
+void HashEntry::operator delete( void* p ) {
+    ::operator delete( p );
+}
+
+void HashEntry::operator delete( void* p, const HashInline& extra ) {
+    if ( extra.arena == 0 ) ::operator delete( p );
+}
+
+HashArena::HashArena() : chunks(0), pos(0), end(0) {}
+
+HashArena::~HashArena() {
+    while ( chunks ) {
+        Chunk* next = chunks->next;
+        ::operator delete( chunks );
+        chunks = next;
+    }
+    pos = end = 0;
+}
+
+void HashArena::addChunk( size_t minSize ) {
+    size_t size = sizeof(Chunk) + minSize;
+    if ( size < HA_CHUNKSIZE ) size = HA_CHUNKSIZE;
+    Chunk* chunk = (Chunk*) ::operator new( size );
+    chunk->next = chunks;
+    chunk->size = size;
+    chunks      = chunk;
+    pos         = (uint8_t*)( chunk + 1 );
+    end         = (uint8_t*) chunk + size;
+}
+
+void* HashArena::alloc( size_t size ) {
+    size = ( size + 7U ) & ~(size_t) 7U;
+    if ( (size_t)( end - pos ) < size ) addChunk( size );
+    void* p = pos;
+    pos += size;
+    return p;
+}
+
+void HashArena::reset() {
+    if ( chunks == 0 ) return;
+    while ( chunks->next ) {
+        Chunk* next = chunks->next;
+        ::operator delete( chunks );
+        chunks = next;
+    }
+    pos = (uint8_t*)( chunks + 1 );
+    end = (uint8_t*) chunks + chunks->size;
 }
 
 HashTable::HashTable() {
-    memset( table, 0, sizeof(HashEntry*) * HT_SIZE );
-    memset( count, 0, sizeof(size_t    ) * HT_SIZE );
+    slots = new HashSlot [ HT_MINSIZE ];
+    memset( slots, 0, sizeof(HashSlot) * HT_MINSIZE );
+    mask  = HT_MINSIZE - 1U;
     total = 0;
+    arena = 0;
+}
+
+HashTable::HashTable( bool withArena ) {
+    slots = new HashSlot [ HT_MINSIZE ];
+    memset( slots, 0, sizeof(HashSlot) * HT_MINSIZE );
+    mask  = HT_MINSIZE - 1U;
+    total = 0;
+    arena = withArena ? new HashArena() : 0;
 }
 
 HashTable::~HashTable() {
     clear();
+    delete [] slots; slots = 0;
+    delete arena; arena = 0;
+}
+
+// multiplies two 64-bit words and folds the 128-bit product
+static inline uint64_t hashMix( uint64_t a, uint64_t b ) {
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128_t;
+    uint128_t r = (uint128_t) a * b;
+    return (uint64_t) r ^ (uint64_t)( r >> 64 );
+#else
+    uint64_t ah = a >> 32, al = (uint32_t) a;
+    uint64_t bh = b >> 32, bl = (uint32_t) b;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    uint64_t mid = ( ll >> 32 ) + (uint32_t) lh + (uint32_t) hl;
+    uint64_t lo  = ( mid << 32 ) | (uint32_t) ll;
+    uint64_t hi  = hh + ( lh >> 32 ) + ( hl >> 32 ) + ( mid >> 32 );
+    return lo ^ hi;
+#endif
+}
+
+static inline uint64_t hashRead8( const uint8_t* p ) {
+    uint64_t v; memcpy( &v, p, 8U ); return v;
+}
+
+static inline uint64_t hashRead4( const uint8_t* p ) {
+    uint32_t v; memcpy( &v, p, 4U ); return v;
+}
+
+#define HASH_P0     UINT64_C(0XA0761D6478BD642F)
+#define HASH_P1     UINT64_C(0XE7037ED1A0B428DB)
+
+// wyhash-style: 16 bytes per step through one wide multiply, with 
+// overlapping reads for the tail so that no byte loop is needed
+uint64_t HashTable::hashName( const uint8_t* name, size_t nameLen ) {
+    uint64_t seed = HASH_P0;
+    uint64_t a, b;
+    if ( nameLen <= 16U ) {
+        if ( nameLen >= 4U ) {
+            size_t d = ( nameLen >> 3 ) << 2;
+            a = ( hashRead4( name ) << 32 ) | hashRead4( name + d );
+            b = ( hashRead4( name + nameLen - 4U ) << 32 ) | 
+                hashRead4( name + nameLen - 4U - d );
+        } else if ( nameLen ) {
+            a = ( (uint64_t) name[0] << 16 ) | 
+                ( (uint64_t) name[nameLen>>1] << 8 ) | name[nameLen-1U];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        const uint8_t* p = name;
+        size_t         n = nameLen;
+        while ( n > 16U ) {
+            seed = hashMix( hashRead8( p ) ^ HASH_P1, 
+                hashRead8( p + 8U ) ^ seed );
+            p += 16U; n -= 16U;
+        }
+        a = hashRead8( p + n - 16U );
+        b = hashRead8( p + n - 8U );
+    }
+    return hashMix( HASH_P1 ^ (uint64_t) nameLen, 
+        hashMix( a ^ HASH_P1, b ^ seed ) );
 }
 
-size_t HashTable::computeHashVal( const uint8_t* name, size_t nameLen ) {
+uint64_t HashTable::legacyHash( const uint8_t* name, size_t nameLen ) {
     uint32_t v1 = UINT32_C(0XFA720BA3);
     uint32_t v2 = UINT32_C(0XD920F8BE);
     uint32_t v3 = UINT32_C(0X7A915F24);
@@ -57,77 +206,167 @@ size_t HashTable::computeHashVal( const uint8_t* name, size_t nameLen ) {
         v3 += v2;
         v  -= v3;
     }
-    v %= (uint32_t) HT_SIZE;
-    return (size_t) v;
+    return v;
+}
+
+void HashTable::insert( HashEntry* ent, uint32_t hash ) {
+    size_t   pos  = hash & mask;
+    uint32_t dist = 1U;
+    for (;;) {
+        HashSlot& s = slots[pos];
+        if ( s.dist == 0 ) {
+            s.ent = ent; s.hash = hash; s.dist = dist;
+            return;
+        }
+        if ( s.dist < dist ) {
+            // take the slot from the richer entry, and go on with it
+            HashEntry* e = s.ent; uint32_t h = s.hash, d = s.dist;
+            s.ent = ent; s.hash = hash; s.dist = dist;
+            ent = e; hash = h; dist = d;
+        }
+        pos = ( pos + 1U ) & mask;
+        ++dist;
+    }
+}
+
+void HashTable::grow() {
+    HashSlot* old     = slots;
+    size_t    oldSize = mask + 1U;
+    size_t    newSize = oldSize * 2U;
+    slots = new HashSlot [ newSize ];
+    memset( slots, 0, sizeof(HashSlot) * newSize );
+    mask  = newSize - 1U;
+    for ( size_t i=0; i < oldSize; ++i ) {
+        if ( old[i].dist ) insert( old[i].ent, old[i].hash );
+    }
+    delete [] old;
 }
 
 void HashTable::enter( HashEntry* hashEntry ) {
-    size_t hv = computeHashVal( hashEntry->name, hashEntry->nameLen );
-    hashEntry->nextHash = table[hv];
-    table[hv] = hashEntry;
-    count[hv] += 1U; total += 1U;
+    if ( ( total + 1U ) * 8U > ( mask + 1U ) * HT_MAXLOAD ) grow();
+    insert( hashEntry, (uint32_t) hashName( hashEntry->name, 
+        hashEntry->nameLen ) );
+    total += 1U;
 }
 
 void HashTable::remove( HashEntry* hashEntry ) {
-    size_t hv = computeHashVal( hashEntry->name, hashEntry->nameLen );
-    HashEntry* prev = 0;
-    HashEntry* curr = table[hv];
-    while ( curr ) {
-        if ( curr->nameLen == hashEntry->nameLen && 
-            memcmp( curr->name, hashEntry->name, 
-                hashEntry->nameLen ) == 0 ) {
-            if ( prev ) {
-                prev->nextHash = curr->nextHash;
-            } else {
-                table[hv] = curr->nextHash;
-            }
-            curr->nextHash = 0;
-            count[hv] -= 1U; total -= 1U;
-            return;
-        }
-        prev = curr; curr = curr->nextHash;
+    uint32_t hash = (uint32_t) hashName( hashEntry->name, 
+        hashEntry->nameLen );
+    size_t   pos  = hash & mask;
+    uint32_t dist = 1U;
+    for (;;) {
+        const HashSlot& s = slots[pos];
+        if ( s.dist < dist ) return;    // empty, or richer: not present
+        if ( s.ent == hashEntry ) break;
+        pos = ( pos + 1U ) & mask;
+        ++dist;
+    }
+    // backward shift: move the following entries one slot closer home
+    for (;;) {
+        size_t    next = ( pos + 1U ) & mask;
+        HashSlot& n    = slots[next];
+        if ( n.dist <= 1U ) break;
+        slots[pos] = n;
+        --slots[pos].dist;
+        pos = next;
     }
+    slots[pos].ent = 0; slots[pos].hash = 0; slots[pos].dist = 0;
+    total -= 1U;
+}
+
+void HashTable::release( HashEntry* hashEntry ) {
+    if ( arena ) hashEntry->~HashEntry();   // memory goes with reset()
+    else delete hashEntry;
 }
 
 HashEntry* HashTable::find( const uint8_t* name, size_t nameLen ) const {
-    size_t hv = computeHashVal( name, nameLen );
-    HashEntry* hashEntry = table[hv];
-    while ( hashEntry ) {
-        if ( hashEntry->nameLen == nameLen && 
-            memcmp( hashEntry->name, name, nameLen ) == 0 ) {
-            return hashEntry;    
+    uint32_t hash = (uint32_t) hashName( name, nameLen );
+    size_t   pos  = hash & mask;
+    uint32_t dist = 1U;
+    for (;;) {
+        const HashSlot& s = slots[pos];
+        if ( s.dist < dist ) return 0;
+        if ( s.hash == hash && s.ent->nameLen == nameLen && 
+            memcmp( s.ent->name, name, nameLen ) == 0 ) {
+            return s.ent;
         }
-        hashEntry = hashEntry->nextHash;
+        pos = ( pos + 1U ) & mask;
+        ++dist;
     }
-    return 0;
 }
 
 void HashTable::clear() {
-    for ( int i=0; i < HT_SIZE; i++ ) {
-        if ( table[i] ) { delete table[i]; table[i] = 0; }
-        count[i] = 0;
+    size_t size = mask + 1U;
+    if ( arena ) {
+        for ( size_t i=0; i < size; ++i ) {
+            if ( slots[i].dist ) slots[i].ent->~HashEntry();
+        }
+        arena->reset();
+    } else {
+        for ( size_t i=0; i < size; ++i ) {
+            if ( slots[i].dist ) delete slots[i].ent;
+        }
     }
+    memset( slots, 0, sizeof(HashSlot) * size );
     total = 0;
 }
 
-void HashTable::dumpCounts() const {
-    size_t x = 0;
-    for ( int i=0; i < HT_SIZE; i++ ) {
-        printf( " %lu", (unsigned long) count[i] );
-        if ( ++x >= 16U ) { printf( "\n" ); x = 0; }
-        else if ( i == HT_SIZE-1 ) printf( "\n" );
+double HashTable::avgProbe() const {
+    if ( total == 0 ) return 0;
+    double sum  = 0;
+    size_t size = mask + 1U;
+    for ( size_t i=0; i < size; ++i ) sum += slots[i].dist;
+    return sum / (double) total;
+}
+
+size_t HashTable::maxProbe() const {
+    size_t max  = 0;
+    size_t size = mask + 1U;
+    for ( size_t i=0; i < size; ++i ) {
+        if ( slots[i].dist > max ) max = slots[i].dist;
     }
+    return max;
 }
 
-double HashTable::coverage() const {
-    if ( total == 0 ) return 0;
-    double sum = 0; size_t max_count = 0;
-    for ( int i=0; i < HT_SIZE; ++i ) {
-        if ( count[i] > max_count ) max_count = count[i];
+static int cmpHash32( const void* a, const void* b ) {
+    uint32_t x = *(const uint32_t*) a, y = *(const uint32_t*) b;
+    return x < y ? -1 : ( x > y ? 1 : 0 );
+}
+
+void HashTable::coverage( HashFunc hashFunc, HashStats& rStats ) const {
+    size_t  size   = mask + 1U;
+    size_t* counts = new size_t [ size ];
+    memset( counts, 0, sizeof(size_t) * size );
+    uint32_t* h32 = new uint32_t [ total + 1U ];
+    size_t    n   = 0;
+    rStats.buckets   = size;
+    rStats.names     = total;
+    rStats.used      = 0;
+    rStats.maxCount  = 0;
+    rStats.dupHashes = 0;
+    for ( size_t i=0; i < size; ++i ) {
+        if ( slots[i].dist == 0 ) continue;
+        const HashEntry* ent = slots[i].ent;
+        uint64_t hash = hashFunc( ent->name, ent->nameLen );
+        size_t&  cnt  = counts[ hash & mask ];
+        if ( cnt++ == 0 ) ++rStats.used;
+        if ( cnt > rStats.maxCount ) rStats.maxCount = cnt;
+        h32[n++] = (uint32_t) hash;
+    }
+    // equal 32-bit hashes can't be told apart by the slots
+    qsort( h32, n, sizeof(uint32_t), cmpHash32 );
+    for ( size_t i=1; i < n; ++i ) {
+        if ( h32[i] == h32[i-1U] ) ++rStats.dupHashes;
     }
-    for ( int i=0; i < HT_SIZE; ++i ) {
-        if ( count[i] ) sum += (long) count[i];
+    double lambda = (double) total / (double) size;
+    double chiSq  = 0;
+    for ( size_t i=0; i < size; ++i ) {
+        double d = (double) counts[i] - lambda;
+        chiSq += d * d;
     }
-    double perc = ( sum * 100 ) / (long)( HT_SIZE * max_count );
-    return perc;
+    rStats.chiSquare = total ? chiSq / lambda / (double) size : 0;
+    double expUsed   = (double) size * ( 1.0 - exp( -lambda ) );
+    rStats.coverage  = total ? rStats.used * 100.0 / expUsed : 0;
+    delete [] h32;
+    delete [] counts;
 }
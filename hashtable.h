@@ -27,46 +27,151 @@
 #include "types.h"
 #endif
 
+// how a HashEntry holds its name
+enum HashNameMode {
+    HN_COPY,    // a copy on the heap
+    HN_INLINE,  // a copy right behind the entry (see operator new)
+    HN_BORROW   // the caller's bytes, which must outlive the entry
+};
+
+// size of the blocks a HashArena takes from the heap
+#define HA_CHUNKSIZE    65536U
+
+// memory for the entries of one table, released all at once by reset()
+class HashArena : public NonCopyable {
+
+    struct Chunk { Chunk* next; size_t size; };    // followed by data
+
+    Chunk*      chunks;     // most recent first
+    uint8_t*    pos;        // free space in chunks
+    uint8_t*    end;
+
+    void addChunk( size_t minSize );
+
+public:
+    HashArena();
+    ~HashArena();
+
+    void* alloc( size_t size );
+    void  reset();          // keeps the first chunk for reuse
+
+};
+
+// tag for allocating an entry with room for an inline name, from the 
+// heap or from an arena:
+// new( HashInline( nameLen, arena ) ) Derived( ..., HN_INLINE, sizeof(Derived) )
+// A plain new would leave no room for the name, so entry classes keep 
+// such constructors private and make their entries with a static 
+// create(), passing the table's arena if it has one
+struct HashInline {
+    size_t      len;
+    HashArena*  arena;
+    explicit HashInline( size_t len_, HashArena* arena_ = 0 ) 
+        : len(len_), arena(arena_) {}
+};
+
 struct HashEntry : public NonCopyable {
 
-    HashEntry*  nextHash;    // next entry with same hash value
-    uint8_t*    name;
-    size_t      nameLen;
+    const uint8_t*  name;
+    uint32_t        nameLen;
+    uint8_t         nameMode;   // HashNameMode
 
     HashEntry( const uint8_t* name_, size_t nameLen_ );
+    // objSize is the size of the most derived class (for HN_INLINE)
+    HashEntry( const uint8_t* name_, size_t nameLen_, HashNameMode mode,
+        size_t objSize );
     virtual ~HashEntry();
 
+    static void* operator new( size_t size );
+    static void* operator new( size_t size, const HashInline& extra );
+    static void operator delete( void* p );
+    static void operator delete( void* p, const HashInline& extra );
+
 };
 
+// initial number of slots (a power of 2)
+#define HT_MINSIZE      16U
 
-#define HT_SIZE     1024
+// the table grows when more than HT_MAXLOAD/8 of the slots are used
+#define HT_MAXLOAD      7U
+
+// open addressing with linear probing, Robin Hood style: an entry
+// that is further from its home slot takes the place of one that is 
+// closer. Each slot keeps the entry's full hash value, so that most 
+// mismatches are rejected without comparing names.
+struct HashSlot {
+    HashEntry*  ent;
+    uint32_t    hash;
+    uint32_t    dist;       // probe distance + 1; 0 = empty slot
+};
+
+// a function that hashes a name, for the diagnostics below
+typedef uint64_t (*HashFunc)( const uint8_t* name, size_t nameLen );
+
+// how evenly a hash function spreads the names of a table over its slots
+struct HashStats {
+    size_t  buckets;    // number of slots
+    size_t  names;      // number of names hashed
+    size_t  used;       // slots that got at least one name
+    size_t  maxCount;   // most names in one slot
+    size_t  dupHashes;  // names whose 32-bit hash was already seen
+    double  coverage;   // used slots in % of the expected number
+    double  chiSquare;  // chi-square per slot (1.0 = uniform)
+};
 
 class HashTable : public NonCopyable {
 
-    HashEntry* table[HT_SIZE];
-    size_t     count[HT_SIZE];
-    size_t     total;
+    HashSlot*  slots;
+    size_t     mask;        // number of slots - 1
+    size_t     total;       // number of entries
+    HashArena* arena;       // where the entries live, or 0 for the heap
 
-    static size_t computeHashVal( const uint8_t* name, 
-        size_t nameLen );
+    void insert( HashEntry* ent, uint32_t hash );
+    void grow();
 
 public:
     HashTable();
+    // withArena: entries are allocated from getArena(), and released
+    // all at once by clear(). For tables that are torn down in bulk:
+    // the memory of removed entries only comes back with clear()
+    explicit HashTable( bool withArena );
     virtual ~HashTable();
 
+    inline HashArena* getArena() const { return arena; }
+
+    // the raw 64-bit hash value of a name; tables reduce it by masking
+    static uint64_t hashName( const uint8_t* name, size_t nameLen );
+
+    // the former byte-at-a-time hash, kept for comparison
+    static uint64_t legacyHash( const uint8_t* name, size_t nameLen );
+
+    // adds an entry, which is deleted by clear() or the destructor.
+    // Names are not checked: with two equal names, find() returns
+    // either one, so callers find() first
     void enter( HashEntry* hashEntry );
 
+    // takes this very entry out (without deleting it)
     void remove( HashEntry* hashEntry );
+
+    // deletes an entry that was taken out (see HashTable( bool ))
+    void release( HashEntry* hashEntry );
     
     HashEntry* find( const uint8_t* name, size_t nameLen ) const;
 
+    // deletes all entries, in one pass over the slots
     void clear();
 
-    void dumpCounts() const;
-    double coverage() const;
+    inline size_t getCount() const { return total; }
+    inline size_t getSize() const { return mask + 1U; }
+
+    // average and longest probe length of the entries
+    double avgProbe() const;
+    size_t maxProbe() const;
+
+    // rehashes the names in the table with hashFunc and rates the spread
+    void coverage( HashFunc hashFunc, HashStats& rStats ) const;
 
 };
 
 
 #endif
-
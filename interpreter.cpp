@@ -23,12 +23,6 @@
 #include "interpreter.h"
 #include "keywords.h"
 
-// --- CmdHashEnt --------------------------------------------------------------------
-
-CmdHashEnt::CmdHashEnt( uint16_t& tok_, CmdMethodPtr mth_ )
-    :   HashEntry( (const uint8_t*)(&tok_), 2U ), mth(mth_) {}
-CmdHashEnt::~CmdHashEnt() {}
-
 // --- IdentInfo ---------------------------------------------------------------------
 
 IdentInfo::IdentInfo() : name(0), nLen(0), desc(0), flags(0), param(0) {}
@@ -52,12 +46,41 @@ ExprInfo::~ExprInfo() {
     if ( param ) { delete param; param = 0; }
 }
 
+// replaces a borrowed value (e.g. a variable) by a copy that may be 
+// modified in place
+void ExprInfo::makeTransient() {
+    if ( bFree ) return;
+    ValDesc* newVal;
+    switch ( value->type ) {
+        case VT_INT:
+            newVal = new IntVal();
+            newVal->setIntVal( value->getIntVal() );
+            break;
+        case VT_REAL:
+            newVal = new RealVal();
+            newVal->setRealVal( value->getRealVal() );
+            break;
+        case VT_STR: {
+            uint8_t* text = 0; size_t len = 0; bool bFree2 = false;
+            value->getStrVal( text, len, bFree2 );
+            newVal = new StrVal( text, len, true );
+            if ( bFree2 ) delete [] text;
+            break;
+        }
+        default:
+            return;
+    }
+    value = newVal;
+    bFree = true;
+}
+
 void ExprInfo::promoteIntToReal() {
     if ( value->type == VT_INT ) {
         ValDesc* newVal = new RealVal();
         newVal->setIntVal( value->getIntVal() );
-        delete value; 
+        if ( bFree ) delete value; 
         value = newVal;
+        bFree = true;
     }
 }
 
@@ -65,8 +88,9 @@ void ExprInfo::demoteRealToInt() {
     if ( value->type == VT_REAL ) {
         ValDesc* newVal = new IntVal();
         newVal->setIntVal( value->getIntVal() );
-        delete value; 
+        if ( bFree ) delete value; 
         value = newVal;
+        bFree = true;
     }
 }
 
@@ -74,8 +98,9 @@ void ExprInfo::changeStrToInt() {
     if ( value->type == VT_STR ) {
         ValDesc* newVal = new IntVal();
         newVal->setIntVal( value->getIntVal() );
-        delete value; 
+        if ( bFree ) delete value; 
         value = newVal;
+        bFree = true;
     }
 }
 
@@ -128,6 +153,16 @@ const CmdDecl Interpreter::cmdDeclTable[] = {
     { KW_LIST, &Interpreter::list  },
     { KW_LET,  &Interpreter::let   },
     { T_PRINT, &Interpreter::print },
+    { KW_LOAD, &Interpreter::load  },
+    { KW_SAVE, &Interpreter::save  },
+    { KW_RUN,  &Interpreter::run   },
+    { KW_GOTO, &Interpreter::jump  },
+    { KW_GOSUB, &Interpreter::gosub },
+    { KW_RETURN, &Interpreter::ret },
+    { KW_END,  &Interpreter::end   },
+    { KW_STOP, &Interpreter::end   },
+    { KW_IF,   &Interpreter::ifThen },
+    { KW_RENUM, &Interpreter::renum },
     { 0, 0 }
 };
 
@@ -142,7 +177,7 @@ void Interpreter::skipTok() {
 }
 
 bool Interpreter::getIdentInfo( IdentInfo& ii ) {
-    const uint8_t* pos = scan.getPos();
+    const XTok* pos = scan.getPos();
     uint16_t tok = scan.tokType(); bool isFN = false;
     if ( tok == KW_FN ) {   // small function reference
         skipTok();
@@ -505,6 +540,7 @@ ExprList* Interpreter::getSignedExpr() {
     try {
         verifySingleNumber( el );
         if ( tok == T_PLUS ) return el;
+        el->first->makeTransient();
         el->first->value->alu( tok );
     } catch ( const Exception& xcpt ) {
         delete el;
@@ -524,6 +560,7 @@ ExprList* Interpreter::getNotExpr() {
     try {
         verifySingleNumber( el );
         if ( el->first->value->type == VT_REAL ) el->first->demoteRealToInt();
+        el->first->makeTransient();
         el->first->value->alu( tok );
     } catch ( const Exception& xcpt ) {
         delete el;
@@ -573,6 +610,7 @@ ExprList* Interpreter::getMultExpr() {
 
             verifySingleNumber( el2 );
             autoPromote( el->first, el2->first );
+            el->first->makeTransient();
             el->first->value->alu( tok, el2->first->value );
 
         } catch ( const Exception& xcpt ) {
@@ -606,6 +644,7 @@ ExprList* Interpreter::getPowExpr() {
 
             verifySingleNumber( el2 );
             autoPromote( el->first, el2->first, true );
+            el->first->makeTransient();
             el->first->value->alu( tok, el2->first->value );
 
         } catch ( const Exception& xcpt ) {
@@ -640,6 +679,7 @@ ExprList* Interpreter::getAddExpr() {
             
             verifySingleNumber( el2 );
             autoPromote( el->first, el2->first );
+            el->first->makeTransient();
             el->first->value->alu( tok, el2->first->value );
 
         } catch ( const Exception& xcpt ) {
@@ -674,6 +714,7 @@ ExprList* Interpreter::getShiftExpr() {
 
             verifySingleNumber( el2 );
             autoDemote( el->first, el2->first );
+            el->first->makeTransient();
             el->first->value->alu( tok, el2->first->value );
 
         } catch ( const Exception& xcpt ) {
@@ -709,6 +750,7 @@ ExprList* Interpreter::getCmpExpr() {
 
             verifySingleNumber( el2 );
             autoPromote( el->first, el2->first );
+            el->first->makeTransient();
             el->first->value->alu( tok, el2->first->value );
             delete el2; el2 = 0;
             if ( el->first->value->type == VT_REAL ) el->first->demoteRealToInt();
@@ -758,6 +800,7 @@ ExprList* Interpreter::getConcatExpr() {
             if ( el2 == 0 ) throw Exception( "syntax error: expression expected" );
         
             verifySingleString( el2 );
+            el->first->makeTransient();
             el->first->value->alu( tok, el2->first->value );
         
         } catch ( const Exception& xcpt ) {
@@ -790,6 +833,7 @@ ExprList* Interpreter::getStrCmpExpr() {
             if ( el2 == 0 ) throw Exception( "syntax error: expression expected" );
         
             verifySingleString( el2 );
+            el->first->makeTransient();
             el->first->value->alu( tok, el2->first->value );
             delete el2; el2 = 0;
             el->first->changeStrToInt();
@@ -837,6 +881,7 @@ ExprList* Interpreter::getAndExpr() {
         
             verifySingleNumber( el2 );
             autoDemote( el->first, el2->first );
+            el->first->makeTransient();
             el->first->value->alu( tok, el2->first->value );
         
         } catch ( const Exception& xcpt ) {
@@ -870,6 +915,7 @@ ExprList* Interpreter::getOrExpr() {
             
             verifySingleNumber( el2 );            
             autoDemote( el->first, el2->first );
+            el->first->makeTransient();
             el->first->value->alu( tok, el2->first->value );
 
         } catch ( const Exception& xcpt ) {
@@ -1069,17 +1115,20 @@ void Interpreter::list() {
     uint32_t lineNo2 = UINT32_MAX;
     getLineNoExpr( lineNo1, lineNo2 );
     size_t count = prog.getLineInfoCount();
-    for ( size_t pos=0; pos < count; ++pos ) {
+    size_t pos;
+    prog.findLine( lineNo1, pos );
+    DetokWriter w( stdout );
+    for ( ; pos < count; ++pos ) {
         const LineInfo& li = prog.getLineInfoAt( pos );
-        if ( li.lineNo < lineNo1 || li.lineNo > lineNo2 ) continue;
+        if ( li.lineNo > lineNo2 ) break;
         prog.setReadPos( li.offset );
         const uint8_t* ptr = prog.readBlock( li.length );
         if ( ptr == 0 ) throw Exception( "list error: bad read" );
-        Detokenizer d( ptr );
-        const char* text = d.detokenize();
-        if ( text == 0 ) throw Exception( "list error: detokenization failed" );
-        printf( "%s\n", text );
+        if ( !w.writeLine( ptr ) ) {
+            throw Exception( "list error: detokenization failed" );
+        }
     }
+    w.flush();
 }
 
 void Interpreter::let() {
@@ -1113,10 +1162,258 @@ void Interpreter::print() {
             ei = ei->next;
             if ( ei ) fputc( '\t', stdout );
         }
+        delete el;
     }
     printf( "\n" );
 }
 
+char* Interpreter::getFileName() {
+    ExprList* el = getStrExpr();
+    if ( el == 0 ) throw Exception( "syntax error: file name expected" );
+    char* fileName = 0;
+    try {
+        verifySingleString( el );
+        uint8_t* text = 0; size_t len = 0; bool bFree = false;
+        el->first->value->getStrVal( text, len, bFree );
+        fileName = new char [ len + 1U ];
+        memcpy( fileName, text, len ); fileName[len] = '\0';
+        if ( bFree ) delete [] text;
+    } catch ( const Exception& xcpt ) {
+        delete el;
+        throw;
+    }
+    delete el;
+    return fileName;
+}
+
+void Interpreter::load() {
+    // the running line's records point into the program being replaced
+    if ( running ) throw Exception( "LOAD error: program is running" );
+    char* fileName = getFileName();
+    try {
+        loadFile( fileName );
+    } catch ( const Exception& xcpt ) {
+        delete [] fileName;
+        throw;
+    }
+    delete [] fileName;
+}
+
+void Interpreter::save() {
+    // SAVE "file" [ , A ]
+    char* fileName = getFileName();
+    try {
+        bool ascii = false;
+        if ( scan.tokType() == T_COMMA ) {
+            skipTok();
+            const uint8_t* text = 0; uint8_t len = 0;
+            if ( scan.tokType() != T_IDENT || !scan.getText( text, len ) ||
+                len != 1U || ( *text != 'A' && *text != 'a' ) ) {
+                throw Exception( "syntax error: A expected" );
+            }
+            skipTok();
+            ascii = true;
+        }
+        if ( ascii ) {
+            prog.saveText( fileName );
+        } else {
+            saveFile( fileName );
+        }
+    } catch ( const Exception& xcpt ) {
+        delete [] fileName;
+        throw;
+    }
+    delete [] fileName;
+}
+
+size_t Interpreter::getJumpTarget() {
+    if ( scan.tokType() == T_LABEL ) {
+        const uint8_t* name = 0; uint8_t len = 0;
+        scan.getText( name, len );
+        size_t line;
+        bool   found;
+        if ( running ) {
+            found = prog.resolveLabel( prog.getCodeIndex( scan.getPos() ),
+                name, len, line );
+        } else {
+            found = prog.findLabel( name, len, line );
+        }
+        if ( !found ) {
+            throw Exception( "undefined label %.*s", (int) len, 
+                (const char*) name );
+        }
+        skipTok();
+        return line;
+    }
+    if ( scan.tokType() != T_LINENO ) {
+        throw Exception( "syntax error: line number expected" );
+    }
+    uint32_t lineNo = 0;
+    scan.getLineNo( lineNo );
+    size_t line;
+    bool   found;
+    if ( running ) {
+        found = prog.resolveJump( prog.getCodeIndex( scan.getPos() ), 
+            lineNo, line );
+    } else {
+        found = prog.findLine( lineNo, line );
+    }
+    if ( !found ) {
+        throw Exception( "undefined line number %lu", (unsigned long) lineNo );
+    }
+    skipTok();
+    return line;
+}
+
+void Interpreter::jumpTo( size_t line ) {
+    if ( !running ) {
+        execute( line );
+        return;
+    }
+    curLine = line;
+    scan.setPos( prog.getLineCode( line ) );
+    jumped = true;
+}
+
+void Interpreter::execute( size_t line ) {
+    size_t count = prog.getLineInfoCount();
+    jumped = true;  // leave the direct mode line afterwards
+    if ( line >= count ) return;
+    prog.prepareRun();
+    running = true;
+    curLine = line;
+    scan.setPos( prog.getLineCode( line ) );
+    try {
+        for (;;) {
+            jumped = false;
+            interpret();
+            if ( !running || !prog.isCodeValid() ) break;
+            if ( !jumped ) {
+                if ( ++curLine >= count ) break;
+                scan.setPos( prog.getLineCode( curLine ) );
+            }
+        }
+    } catch ( const Exception& xcpt ) {
+        running = false; jumped = true; nGosub = 0;
+        throw Exception( "%s in line %lu", xcpt.what(), 
+            (unsigned long) prog.getLineInfoAt( curLine ).lineNo );
+    }
+    running = false; jumped = true; nGosub = 0;
+}
+
+void Interpreter::run() {
+    size_t   line = 0;
+    uint16_t tok  = scan.tokType();
+    if ( tok == T_LINENO || tok == T_LABEL ) line = getJumpTarget();
+    clearVars();
+    nGosub = 0;
+    if ( running ) {
+        jumpTo( line );
+    } else {
+        execute( line );
+    }
+}
+
+void Interpreter::jump() {
+    jumpTo( getJumpTarget() );
+}
+
+void Interpreter::gosub() {
+    size_t line = getJumpTarget();
+    if ( nGosub >= MAXGOSUB ) throw Exception( "GOSUB nesting too deep" );
+    GosubFrame& f = gosubStack[nGosub++];
+    f.line = curLine;
+    f.pos  = running ? scan.getPos() : 0;
+    jumpTo( line );
+}
+
+void Interpreter::ret() {
+    if ( nGosub == 0 ) throw Exception( "RETURN without GOSUB" );
+    const GosubFrame& f = gosubStack[--nGosub];
+    uint16_t tok = scan.tokType();
+    if ( tok == T_LINENO || tok == T_LABEL ) {  // RETURN line
+        jumpTo( getJumpTarget() );
+        return;
+    }
+    if ( !running ) return;
+    if ( f.pos == 0 ) {     // back to direct mode
+        running = false;
+        jumped  = true;
+        return;
+    }
+    curLine = f.line;
+    scan.setPos( f.pos );
+    jumped  = true;
+}
+
+void Interpreter::end() {
+    if ( !running ) return;
+    running = false;
+    jumped  = true;
+}
+
+void Interpreter::ifThen() {
+    ExprList* el = getExpr();
+    if ( el == 0 ) throw Exception( "syntax error: expression expected" );
+    bool cond;
+    try {
+        verifySingleNumber( el );
+        ValDesc* val = el->first->value;
+        if ( val->type == VT_INT ) {
+            cond = val->getIntVal() != 0;
+        } else {
+            cond = val->getRealVal() != 0.0;
+        }
+    } catch ( const Exception& xcpt ) {
+        delete el;
+        throw;
+    }
+    delete el;
+    uint16_t tok = scan.tokType();
+    if ( tok == KW_THEN ) {
+        skipTok();
+        tok = scan.tokType();
+    } else if ( tok != KW_GOTO ) {
+        throw Exception( "syntax error: THEN expected" );
+    }
+    if ( !cond ) {
+        // skip the rest of the line
+        while ( scan.tokType() != T_EOL ) skipTok();
+        return;
+    }
+    if ( tok == T_LINENO || tok == T_LABEL ) jumpTo( getJumpTarget() );
+    // otherwise, the statements after THEN or the GOTO follow
+}
+
+void Interpreter::renum() {
+    // RENUM [ new [, step [, old ] ] ]
+    uint32_t args[3] = { 10U, 10U, 0U };
+    ExprList* el = getExprList();
+    if ( el ) {
+        try {
+            ExprInfo* ei = el->first;
+            for ( int i=0; ei; ++i, ei = ei->next ) {
+                ValDesc* val = ei->value;
+                if ( i >= 3 ) throw Exception( "syntax error: too many arguments" );
+                if ( val->type != VT_INT && val->type != VT_REAL ) {
+                    throw Exception( "syntax error: number expected" );
+                }
+                int64_t n = val->getIntVal();
+                if ( n < 0 || n > (int64_t) UINT24_MAX ) {
+                    throw Exception( "RENUM error: bad line number" );
+                }
+                args[i] = (uint32_t) n;
+            }
+        } catch ( const Exception& xcpt ) {
+            delete el;
+            throw;
+        }
+        delete el;
+    }
+    if ( running ) throw Exception( "RENUM error: program is running" );
+    prog.renum( args[0], args[1], args[2] );
+}
+
 void Interpreter::funcHandler( FuncArg* arg ) {
     FnArg* fnArg = dynamic_cast<FnArg*>( arg );
     if ( fnArg == 0 ) throw Exception( "call error: bad function" );
@@ -1125,8 +1422,10 @@ void Interpreter::funcHandler( FuncArg* arg ) {
 }
 
 void Interpreter::declareCmd( const CmdDecl& decl ) {
-    uint16_t tok = decl.tok;
-    commandHt.enter( new CmdHashEnt( tok, decl.mth ) );
+    if ( decl.tok >= CMD_TABSIZE ) {
+        throw Exception( "declare error: bad command token" );
+    }
+    cmdTab[decl.tok] = decl.mth;
 }
 
 void Interpreter::declareFunc( const FnDecl& decl ) {
@@ -1145,6 +1444,8 @@ void Interpreter::declareFunc( const FnDecl& decl ) {
 }
 
 void Interpreter::declare() {
+    cmdTab = new CmdMethodPtr [ CMD_TABSIZE ];
+    for ( size_t i=0; i < CMD_TABSIZE; ++i ) cmdTab[i] = 0;
     for ( int i=0; cmdDeclTable[i].tok; ++i ) {
         declareCmd( cmdDeclTable[i] );
     }
@@ -1158,11 +1459,13 @@ void Interpreter::clearVars( bool declareOnly ) {
     }
 }
 
-Interpreter::Interpreter() {    
+Interpreter::Interpreter() : cmdTab(0), tokenizer( 0, 0 ), running(false), 
+    jumped(false), curLine(0), nGosub(0) {    
     declare();
 }
 
 Interpreter::~Interpreter() {
+    delete [] cmdTab; cmdTab = 0;
 }
 
 void Interpreter::interpret() {
@@ -1171,14 +1474,10 @@ void Interpreter::interpret() {
         if ( tok == T_EOL ) break;
         skipTok();
         if ( tok == T_LINENO || tok == T_LABEL || tok == T_COLON ) continue;
-        HashEntry* he = commandHt.find( (const uint8_t*)(&tok), 2U );
-        if ( he ) {
-            CmdHashEnt* cmd = dynamic_cast<CmdHashEnt*>( he );
-            if ( cmd == 0 ) {
-                throw Exception( "interpret error: bad command" );
-            }
-            CmdMethodPtr mth = cmd->mth;
+        CmdMethodPtr mth = tok < CMD_TABSIZE ? cmdTab[tok] : 0;
+        if ( mth ) {
             (this->*mth)();
+            if ( jumped ) return;
             continue;
         }
         throw Exception( "interpret error: command not implemented" );
@@ -1186,21 +1485,32 @@ void Interpreter::interpret() {
 }
 
 void Interpreter::interpretLine( const char* line ) {
-    Tokenizer t( (const uint8_t*) line, strlen(line) );
-    uint16_t tok = t.tokenize();
+    tokenizer.reset( (const uint8_t*) line, strlen(line) );
+    uint16_t tok = tokenizer.tokenize();
     if ( tok != T_EOL ) {
         // TODO: error handling
         printf( "error, %d\n", tok );
 
         return;
     }
-    scan.setPos( t.getTokBufAddr() );
-    tok = scan.tokType();
-    if ( tok == T_LINENO ) {
-        uint32_t lineNo;
-        if ( !scan.getLineNo( lineNo ) ) return;
-        prog.enterLine( t );
+    const uint8_t* toks = tokenizer.getTokBufAddr();
+    if ( *toks == T_LINENO ) {
+        prog.enterLine( tokenizer );
         return;
     }
+    stream.clear();
+    if ( !stream.append( toks ) ) {
+        throw Exception( "interpret error: bad token" );
+    }
+    scan.setPos( stream.getAt( 0 ) );
+    jumped = false;
     interpret();
 }
+
+void Interpreter::loadFile( const char* fileName ) {
+    prog.load( fileName, getNumCPUs() );
+}
+
+void Interpreter::saveFile( const char* fileName ) {
+    prog.save( fileName );
+}
@@ -31,8 +31,8 @@
 #include "tokenizer.h"
 #endif
 
-#ifndef TOKENSCANNER_H
-#include "tokenscanner.h"
+#ifndef TOKENSTREAM_H
+#include "tokenstream.h"
 #endif
 
 #ifndef EXCEPTION_H
@@ -58,13 +58,9 @@
 class Interpreter;
 typedef void (Interpreter::*CmdMethodPtr)();
 
-struct CmdHashEnt : public HashEntry {
-
-    CmdMethodPtr mth;   // method in Interpreter class
-
-    CmdHashEnt( uint16_t& tok_, CmdMethodPtr mth_ );
-    virtual ~CmdHashEnt();
-};
+// statement handlers are indexed by token: 0X0000..0X0FFF covers all 
+// token banks (see KW_NBANKS)
+#define CMD_TABSIZE     4096U
 
 struct CmdDecl { uint16_t tok; CmdMethodPtr mth; };
 
@@ -86,6 +82,14 @@ struct FnArg : public FuncArg { // for FuncVal
     FnMethodPtr     mth; 
 };
 
+// GOSUB nesting depth
+#define MAXGOSUB    1024
+
+struct GosubFrame {
+    size_t          line;   // index of the line of the GOSUB
+    const XTok*     pos;    // where to continue (0 = direct mode)
+};
+
 #define IIF_INT     1
 #define IIF_STR     2
 #define IIF_FN      4
@@ -113,6 +117,7 @@ struct ExprInfo : public NonCopyable {
 
     inline ValDesc* detachValue() { ValDesc* ret = value; value = 0; return ret; }
 
+    void makeTransient();
     void promoteIntToReal();
     void demoteRealToInt();
     void changeStrToInt();
@@ -132,9 +137,18 @@ struct ExprList : public NonCopyable {
 class Interpreter : public NonCopyable {
 
     Program         prog;
-    HashTable       commandHt;
+    CmdMethodPtr*   cmdTab;     // CMD_TABSIZE entries, 0 = no command
     Variables       vars;
-    TokenScanner    scan;
+    StreamScanner   scan;
+    Tokenizer       tokenizer;  // reused for every direct mode line
+    TokenStream     stream;     // decoded direct mode line
+
+    // program execution state
+    bool            running;    // executing program lines
+    bool            jumped;     // control was transferred: leave the line
+    size_t          curLine;    // index of the executing line
+    size_t          nGosub;     // GOSUB stack depth
+    GosubFrame      gosubStack[MAXGOSUB];
 
     static const CmdDecl cmdDeclTable[];
     static const FnDecl funcDeclTable[];
@@ -344,6 +358,26 @@ class Interpreter : public NonCopyable {
     void list();
     void let();
     void print();
+    char* getFileName();
+        // reads a string expression; the result must be deleted
+    void load();
+    void save();
+    void run();
+    void jump();        // GOTO
+    void gosub();
+    void ret();         // RETURN
+    void end();         // END, STOP
+    void ifThen();      // IF expr THEN line | IF expr THEN statements
+    void renum();
+
+    size_t getJumpTarget();
+        // reads a line number or label and returns the index of that line
+
+    void jumpTo( size_t line );
+        // continues at line (starts execution in direct mode)
+
+    void execute( size_t line );
+        // executes the program from line until the end or END
 
     static void funcHandler( FuncArg* arg );
 
@@ -354,7 +388,7 @@ class Interpreter : public NonCopyable {
     void clearVars( bool declareOnly = false ); 
         // clear all variables, then redeclare built-in stuff
 
-    // interpret a line of tokens (direct mode)
+    // interpret a line of tokens; returns at T_EOL or after a jump
     void interpret();
 
 public:
@@ -363,6 +397,12 @@ public:
 
     // interpret a line in direct mode
     void interpretLine( const char* line );
+
+    // replace the program by an ASCII source file or a program image
+    void loadFile( const char* fileName );
+
+    // write the program as a program image
+    void saveFile( const char* fileName );
     
 };
 
@@ -24,11 +24,18 @@
 #include "tokens.h"
 
 KW_Hashent::KW_Hashent( const char* p, unsigned char len, 
-    uint16_t tok_ ) : HashEntry( (const uint8_t*) p, len ),
-    tok(tok_) {}
+    uint16_t tok_, HashNameMode mode ) : HashEntry( (const uint8_t*) p, 
+    len, mode, sizeof(KW_Hashent) ), tok(tok_) {}
 
-KW_Hashent2::KW_Hashent2( const uint16_t& tok, const char* text_ )
-    : HashEntry( (const uint8_t*)(&tok), 2U ), text(text_) {}
+KW_Hashent* KW_Hashent::create( const char* p, unsigned char len, 
+    uint16_t tok_ ) {
+    return new( HashInline( len ) ) KW_Hashent( p, len, tok_, HN_INLINE );
+}
+
+KW_Hashent* KW_Hashent::borrow( const char* p, unsigned char len, 
+    uint16_t tok_ ) {
+    return new KW_Hashent( p, len, tok_, HN_BORROW );
+}
 
 const PredefKW Keywords::predef[] = {
     { "\3NOP", KW_NOP },
@@ -176,16 +183,148 @@ const PredefKW Keywords::predef[] = {
     { 0, 0 }
 };
 
-Keywords::Keywords() { init(); }
-Keywords::~Keywords() {}
+Keywords::Keywords() : slots(0), disp(0), nSlots(0), bucketMask(0), 
+    seed(0), maxLen(0), nAdded(0) { 
+    for ( int i=0; i < KW_NBANKS; ++i ) tokText[i] = 0;
+    init(); 
+}
+
+Keywords::~Keywords() {
+    for ( int i=0; i < KW_NBANKS; ++i ) delete [] tokText[i];
+    delete [] slots;
+    delete [] disp;
+}
+
+// Hashes names of up to 16 bytes without a loop: the first and last
+// word (overlapping for shorter names) cover every byte. Longer names
+// are never looked up in the perfect hash (see maxLen).
+uint64_t Keywords::hashName( const uint8_t* name, size_t nameLen, 
+    uint64_t seed ) {
+    uint64_t a, b;
+    if ( nameLen >= 8U ) {
+        memcpy( &a, name, 8U ); memcpy( &b, name + nameLen - 8U, 8U );
+    } else if ( nameLen >= 4U ) {
+        uint32_t a4, b4;
+        memcpy( &a4, name, 4U ); memcpy( &b4, name + nameLen - 4U, 4U );
+        a = a4; b = b4;
+    } else if ( nameLen > 0U ) {
+        a = ( (uint64_t) name[0] << 16U ) | 
+            ( (uint64_t) name[nameLen>>1U] << 8U ) | name[nameLen-1U];
+        b = 0;
+    } else {
+        a = b = 0;
+    }
+    uint64_t h = ( a ^ seed ^ (uint64_t) nameLen ) * 
+        UINT64_C(0X9E3779B97F4A7C15);
+    h ^= h >> 29U;
+    h += b * UINT64_C(0XBF58476D1CE4E5B9);
+    h ^= h >> 32U;
+    h *= UINT64_C(0X94D049BB133111EB);
+    h ^= h >> 29U;
+    return h;
+}
+
+bool Keywords::buildPerfectHash( uint32_t nKeys ) {
+
+    uint32_t nBuckets = 1U;
+    while ( nBuckets * 2U < nKeys ) nBuckets <<= 1U;
+
+    nSlots     = nKeys;
+    bucketMask = nBuckets - 1U;
+    slots      = new KW_Slot [ nSlots ];
+    disp       = new uint16_t [ nBuckets ];
+
+    uint64_t* hv     = new uint64_t [ nKeys ];
+    uint32_t* bucket = new uint32_t [ nKeys ];
+    uint32_t* bsize  = new uint32_t [ nBuckets ];
+    uint32_t* keys   = new uint32_t [ nKeys ];
+    bool*     taken  = new bool [ nSlots ];
+
+    bool ok = false;
+    for ( int attempt=0; !ok && attempt < 64; ++attempt ) {
+
+        seed = UINT64_C(0X2545F4914F6CDD1D) * (uint64_t)( attempt + 1 );
+
+        uint32_t maxSize = 0;
+        memset( bsize, 0, nBuckets * sizeof(uint32_t) );
+        memset( disp,  0, nBuckets * sizeof(uint16_t) );
+        memset( taken, 0, nSlots * sizeof(bool) );
+        for ( uint32_t i=0; i < nKeys; ++i ) {
+            const char* p = predef[i].text;
+            hv[i]     = hashName( (const uint8_t*) p + 1, (uint8_t) *p, seed );
+            bucket[i] = ( (uint32_t) hv[i] >> 16U ) & bucketMask;
+            if ( ++bsize[bucket[i]] > maxSize ) maxSize = bsize[bucket[i]];
+        }
+
+        // place the largest buckets first, while most slots are free
+        ok = true;
+        for ( uint32_t size=maxSize; ok && size > 0; --size ) {
+            for ( uint32_t b=0; ok && b < nBuckets; ++b ) {
+                if ( bsize[b] != size ) continue;
+                uint32_t nk = 0;
+                for ( uint32_t i=0; i < nKeys; ++i ) {
+                    if ( bucket[i] == b ) keys[nk++] = i;
+                }
+                ok = false;
+                for ( uint32_t d=0; !ok && d <= UINT32_C(0XFFFF); ++d ) {
+                    disp[b] = (uint16_t) d;
+                    uint32_t k;
+                    for ( k=0; k < nk; ++k ) {
+                        uint32_t s = slotIndex( hv[keys[k]] );
+                        if ( taken[s] ) break;
+                        taken[s] = true;
+                    }
+                    if ( k == nk ) { ok = true; break; }
+                    while ( k-- ) taken[ slotIndex( hv[keys[k]] ) ] = false;
+                }
+                if ( !ok ) break;
+                for ( uint32_t k=0; k < nk; ++k ) {
+                    const char* p  = predef[keys[k]].text;
+                    KW_Slot&    sl = slots[ slotIndex( hv[keys[k]] ) ];
+                    sl.text = p + 1;
+                    sl.len  = (uint8_t) *p;
+                    sl.tok  = (uint16_t) predef[keys[k]].tok;
+                }
+            }
+        }
+    }
+
+    delete [] taken;
+    delete [] keys;
+    delete [] bsize;
+    delete [] bucket;
+    delete [] hv;
+
+    if ( !ok ) {
+        delete [] slots; slots = 0;
+        delete [] disp;  disp  = 0;
+        nSlots = 0;
+    }
+    return ok;
+}
 
 void Keywords::init() {
+    uint32_t nKeys = 0;
     for ( int i=0; predef[i].text; ++i ) {
         const char*     p   = predef[i].text;
         unsigned char   len = *p++;
         uint16_t        tok = (uint16_t) predef[i].tok;
-        ht.enter( new KW_Hashent( p, len, tok ) );
-        ht2.enter( new KW_Hashent2( tok, p ) );
+        const char**    bank = tokText[ tok >> 8U ];
+        if ( bank == 0 ) {
+            bank = tokText[ tok >> 8U ] = new const char* [256];
+            for ( int j=0; j < 256; ++j ) bank[j] = 0;
+        }
+        bank[ tok & UINT16_C(0XFF) ] = predef[i].text;
+        if ( len > maxLen ) maxLen = len;
+        ++nKeys;
+    }
+    if ( maxLen > 16U || !buildPerfectHash( nKeys ) ) {
+        // cannot happen with the current keyword set; keep working anyway
+        for ( uint32_t i=0; i < nKeys; ++i ) {
+            const char* p = predef[i].text;
+            add( (const uint8_t*) p + 1, (uint8_t) *p, 
+                (uint16_t) predef[i].tok );
+        }
     }
 }
 
@@ -193,12 +332,26 @@ Keywords Keywords::instance;
 
 void Keywords::add( const uint8_t* name, size_t nameLen, 
     uint16_t tok ) {
-    ht.enter( new KW_Hashent( (const char*) name, 
+    // the latest definition of a name wins
+    KW_Hashent* kw = dynamic_cast<KW_Hashent*>( ht.find( name, nameLen ) );
+    if ( kw ) { kw->tok = tok; return; }
+    ht.enter( KW_Hashent::create( (const char*) name, 
         (unsigned char) nameLen, tok ) );
+    ++nAdded;
 }
 
 uint16_t Keywords::lookup( const uint8_t* name, size_t nameLen ) const {
 
+    if ( nSlots && nameLen <= maxLen ) {
+        const KW_Slot& sl = slots[ slotIndex( hashName( name, nameLen, 
+            seed ) ) ];
+        if ( sl.len == nameLen && memcmp( sl.text, name, nameLen ) == 0 ) {
+            return sl.tok;
+        }
+    }
+
+    if ( nAdded == 0 ) return KW_NOTFOUND;
+
     HashEntry* ent = ht.find( name, nameLen );
     if ( ent == 0 ) return KW_NOTFOUND;
 
@@ -207,15 +360,3 @@ uint16_t Keywords::lookup( const uint8_t* name, size_t nameLen ) const {
 
     return kw->tok;
 }
-
-const char* Keywords::lookup( uint16_t tok ) const {
-
-    uint16_t tmp( tok );
-    HashEntry* ent = ht2.find( (const uint8_t*)(&tmp), 2U );
-    if ( ent == 0 ) return 0;
-
-    KW_Hashent2* kw = dynamic_cast<KW_Hashent2*>( ent );
-    if ( kw == 0 ) return 0;
-
-    return kw->text;
-}
\ No newline at end of file
@@ -29,6 +29,8 @@
 
 #define KW_NOTFOUND UINT16_C(0XFFFF)
 
+#define KW_NBANKS   16  // token banks 0X00..0X0F (0X00 = single-byte tokens)
+
 struct PredefKW {
     const char* text;   // counted string (1st byte = length)
     short       tok;
@@ -38,29 +40,62 @@ struct KW_Hashent : public HashEntry {  // lookup by name
 
     uint16_t tok;
 
-    KW_Hashent( const char* p, unsigned char len, uint16_t tok_ );
+    static KW_Hashent* create( const char* p, unsigned char len, 
+        uint16_t tok_ );
+    // refers to the name instead of copying it (e.g. a predefined keyword)
+    static KW_Hashent* borrow( const char* p, unsigned char len, 
+        uint16_t tok_ );
 
+private:
+    KW_Hashent( const char* p, unsigned char len, uint16_t tok_,
+        HashNameMode mode );
 };
 
-struct KW_Hashent2 : public HashEntry { // lookup by token
-
-    const char* text;
+struct KW_Slot {    // slot in the perfect hash table
 
-    KW_Hashent2( const uint16_t& tok, const char* text_ );
+    const char* text;   // keyword text (not NUL-terminated)
+    uint16_t    tok;
+    uint8_t     len;
 
 };
 
 class Keywords : private NonCopyable {
 
-    HashTable ht,   // lookup by name
-              ht2;  // lookup by token
+    HashTable ht;   // lookup by name (keywords added at runtime)
+
+    // lookup by token: tokText[bank][index] points to the counted
+    // string from predef[], or is 0. Unused banks are not allocated.
+    const char** tokText[KW_NBANKS];
 
     static const PredefKW predef[];
 
+    // minimal perfect hash over predef[], built once by init():
+    // the hash value selects a bucket, the bucket's displacement
+    // selects exactly one slot, which is the only possible match.
+    KW_Slot*    slots;      // nSlots entries
+    uint16_t*   disp;       // bucketMask + 1 entries
+    uint32_t    nSlots;
+    uint32_t    bucketMask;
+    uint64_t    seed;
+    size_t      maxLen;     // longest predefined keyword
+    size_t      nAdded;     // number of keywords in ht
+
     Keywords();
     virtual ~Keywords();
 
     void init();    // add predefined keywords
+    bool buildPerfectHash( uint32_t nKeys );
+
+    static uint64_t hashName( const uint8_t* name, size_t nameLen, 
+        uint64_t seed );
+
+    inline uint32_t slotIndex( uint64_t hv ) const {
+        uint32_t h1 = (uint32_t) hv;
+        uint32_t h2 = (uint32_t)( hv >> 32U ) | 1U;
+        uint32_t d  = disp[ ( h1 >> 16U ) & bucketMask ];
+        return (uint32_t)( ( (uint64_t)(uint32_t)( h1 + d * h2 ) * 
+            nSlots ) >> 32U );
+    }
 
     // initialized at start of program
     static Keywords instance;
@@ -69,11 +104,28 @@ public:
 
     static inline Keywords& getInstance() { return instance; }
 
+    static inline const PredefKW* getPredef() { return predef; }
+
+    // the lookup functions may be called from several threads at
+    // once; add() must not run concurrently with them.
+
     void add( const uint8_t* name, size_t nameLen, uint16_t tok );
 
     uint16_t lookup( const uint8_t* name, size_t nameLen ) const;
 
-    const char* lookup( uint16_t tok ) const;
+    // returns the keyword text (length in text[-1]), or 0
+    inline const char* lookup( uint16_t tok ) const {
+        uint16_t bank = tok >> 8U;
+        if ( bank >= KW_NBANKS || tokText[bank] == 0 ) return 0;
+        const char* p = tokText[bank][tok & UINT16_C(0XFF)];
+        return p ? p + 1 : 0;
+    }
+
+    inline const char* lookup( uint16_t tok, size_t& rLen ) const {
+        const char* p = lookup( tok );
+        rLen = p ? (uint8_t) p[-1] : 0;
+        return p;
+    }
 
 };
 
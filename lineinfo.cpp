@@ -28,9 +28,36 @@ void LineInfoManager::expand() {
     if ( count ) {
         memcpy( newInfo, info, sizeof(LineInfo) * count );
     }
-    delete [] info;
-    info  = newInfo;
-    alloc = newAlloc;
+    if ( freeInfo ) delete [] info;
+    info     = newInfo;
+    alloc    = newAlloc;
+    freeInfo = true;
+}
+
+void LineInfoManager::attach( const LineInfo* info_, size_t count_ ) {
+    if ( freeInfo ) delete [] info;
+    info     = (LineInfo*) info_;
+    count    = alloc = count_;
+    freeInfo = false;
+    haveLastLineNumber = count > 0U;
+    lastLineNumber     = count ? info[count-1U].lineNo : 0;
+}
+
+void LineInfoManager::own( bool keep ) {
+    if ( freeInfo ) return;
+    if ( !keep ) count = 0;
+    size_t    newAlloc = count < MINLINEINFO ? MINLINEINFO : count * 2U;
+    LineInfo* newInfo  = new LineInfo [ newAlloc ];
+    if ( count ) memcpy( newInfo, info, sizeof(LineInfo) * count );
+    info     = newInfo;
+    alloc    = newAlloc;
+    freeInfo = true;
+    if ( !keep ) clear();
+}
+
+void LineInfoManager::lineNumbersChanged() {
+    haveLastLineNumber = count > 0U;
+    lastLineNumber     = count ? info[count-1U].lineNo : 0;
 }
 
 LineInfoManager::LineInfoManager( size_t minlineinfo ) {
@@ -39,14 +66,46 @@ LineInfoManager::LineInfoManager( size_t minlineinfo ) {
     alloc              = minlineinfo;;
     lastLineNumber     = 0;
     haveLastLineNumber = false;
+    freeInfo           = true;
 }
 
 LineInfoManager::~LineInfoManager() {
-    delete [] info; info = 0; count = alloc = 0;
+    if ( freeInfo ) delete [] info; 
+    info = 0; count = alloc = 0;
     lastLineNumber     = 0;
     haveLastLineNumber = false;
 }
 
+bool LineInfoManager::find( uint32_t lineNo, size_t& rPos ) const {
+    size_t lo = 0, hi = count;
+    while ( lo < hi ) {
+        size_t mid = lo + ( hi - lo ) / 2U;
+        if ( info[mid].lineNo < lineNo ) lo = mid + 1U; else hi = mid;
+    }
+    rPos = lo;
+    return lo < count && info[lo].lineNo == lineNo;
+}
+
+bool LineInfoManager::bulkAppend( const LineInfo* src, size_t n ) {
+    if ( n == 0 ) return true;
+    while ( count + n > alloc ) expand();
+    memcpy( &info[count], src, sizeof(LineInfo) * n );
+    size_t pos = count;
+    if ( info[pos].length == 0 || 
+        ( haveLastLineNumber && info[pos].lineNo <= lastLineNumber ) ) {
+        return false;
+    }
+    for ( ++pos; pos < count + n; ++pos ) {
+        if ( info[pos].length == 0 || info[pos].lineNo <= info[pos-1U].lineNo ) {
+            return false;
+        }
+    }
+    count += n;
+    lastLineNumber     = info[count-1U].lineNo;
+    haveLastLineNumber = true;
+    return true;
+}
+
 void LineInfoManager::append( const LineInfo& src ) {
     if ( count >= alloc ) expand();
     info[count++] = src;
@@ -66,26 +125,19 @@ void LineInfoManager::insert( const LineInfo& src, size_t pos ) {
     count++;
 }
 
-void LineInfoManager::insert( const LineInfo& src ) {
+uint32_t LineInfoManager::insert( const LineInfo& src ) {
     if ( !haveLastLineNumber || src.lineNo > lastLineNumber ) {
         append( src );
-        return;
+        return 0;
     }
-    if ( src.lineNo == lastLineNumber ) {
-        info[count-1] = src;
-        return;
-    }
-    for ( size_t pos=0; pos < count; ++pos ) {
-        if ( src.lineNo == info[pos].lineNo ) {
-            info[pos] = src;
-            return;
-        }
-        if ( src.lineNo < info[pos].lineNo ) {
-            insert( src, pos );
-            return;
-        }
+    size_t pos;
+    if ( find( src.lineNo, pos ) ) {
+        uint32_t oldLength = info[pos].length;
+        info[pos] = src;
+        return oldLength;
     }
-    append( src );
+    insert( src, pos );
+    return 0;
 }
 
 void LineInfoManager::deleteAt( size_t pos ) {
@@ -99,12 +151,12 @@ void LineInfoManager::deleteAt( size_t pos ) {
     --count;
 }
 
-void LineInfoManager::deleteLine( uint32_t lineNo ) {
-    for ( size_t pos=0; pos < count; ++pos ) {
-        if ( info[pos].lineNo == lineNo ) {
-            deleteAt( pos );
-            break;
-        }
+uint32_t LineInfoManager::deleteLine( uint32_t lineNo ) {
+    uint32_t oldLength = 0;
+    size_t   pos;
+    if ( find( lineNo, pos ) ) {
+        oldLength = info[pos].length;
+        deleteAt( pos );
     }
     if ( haveLastLineNumber && lastLineNumber == lineNo ) {
         if ( count > 0U ) {
@@ -114,5 +166,11 @@ void LineInfoManager::deleteLine( uint32_t lineNo ) {
             haveLastLineNumber = false;
         }
     }
+    return oldLength;
 }
 
+void LineInfoManager::clear() {
+    count              = 0;
+    lastLineNumber     = 0;
+    haveLastLineNumber = false;
+}
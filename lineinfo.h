@@ -43,6 +43,7 @@ class LineInfoManager : public NonCopyable {
     size_t      alloc;
     uint32_t    lastLineNumber;
     bool        haveLastLineNumber;
+    bool        freeInfo;   // false: external, read-only entries
 
     void expand();
 
@@ -51,6 +52,13 @@ public:
     virtual ~LineInfoManager();
 
     inline size_t getCount() const { return count; }
+
+    // uses count_ sorted entries in external, read-only memory. No
+    // changes are allowed until own() is called.
+    void attach( const LineInfo* info_, size_t count_ );
+
+    // switches to own memory, copying the entries if keep is true
+    void own( bool keep = true );
     
     inline LineInfo& getAt( size_t pos ) {
         return info[pos];
@@ -60,11 +68,27 @@ public:
         return info[pos];
     }
 
+    // binary search: returns true if lineNo is present, at rPos; 
+    // otherwise, rPos is where it would have to be inserted
+    bool find( uint32_t lineNo, size_t& rPos ) const;
+
     void append( const LineInfo& src );
+
+    // appends n lines that must be sorted, with line numbers above all
+    // present ones and non-zero lengths. This is checked once, after 
+    // copying; if it fails, nothing is appended and false is returned.
+    bool bulkAppend( const LineInfo* src, size_t n );
+
     void insert( const LineInfo& src, size_t pos );
-    void insert( const LineInfo& src );
+    // insert() and deleteLine() return the length of the line replaced
+    // or deleted, or 0 if there was none
+    uint32_t insert( const LineInfo& src );
     void deleteAt( size_t pos );
-    void deleteLine( uint32_t lineNo );
+    // to be called after line numbers were changed through getAt();
+    // they must still be ascending
+    void lineNumbersChanged();
+    uint32_t deleteLine( uint32_t lineNo );
+    void clear();
 
 };
 
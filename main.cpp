@@ -20,10 +20,35 @@
         E-Mail: ekkehard@ekkehardmorgenstern.de
         Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
 
-#include "types.h"
+#include "interpreter.h"
 
 int main( int argc, char** argv ) {
 
+    Interpreter intp;
+
+    if ( argc > 1 ) {
+        try {
+            intp.loadFile( argv[1] );
+        }
+        catch ( const Exception& xcpt ) {
+            fprintf( stderr, "? %s\n", xcpt.what() );
+            return EXIT_FAILURE;
+        }
+    }
+
+    char buf[1024];
+    while ( fgets( buf, sizeof(buf), stdin ) ) {
+        size_t len = strlen(buf);
+        if ( len > 0U && buf[len-1U] == '\n' ) buf[--len] = '\0';
+
+        try {
+            intp.interpretLine( buf );
+        }
+        catch ( const Exception& xcpt ) {
+            printf( "? %s\n", xcpt.what() );
+        }
+
+    }
 
     return EXIT_SUCCESS;
 }
@@ -23,45 +23,196 @@
 #include "program.h"
 #include "exception.h"
 #include "tokenscanner.h"
+#include "detokenizer.h"
 
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+struct LineRef { uint32_t offset; uint32_t index; };
+
+static int cmpLineRef( const void* a, const void* b ) {
+    uint32_t oa = ((const LineRef*) a)->offset;
+    uint32_t ob = ((const LineRef*) b)->offset;
+    return oa < ob ? -1 : ( oa > ob ? 1 : 0 );
+}
+
+// called when the buffer is full. Unless enough of it is dead, returns
+// without change, so that the buffer is grown instead. Otherwise, the
+// live lines are slid down in offset order, in place.
 void Program::compact( ByteBuffer& buf ) {
-    if ( buf.getWritePos() == 0 ) return; // ?? should NOT occur
-    ByteBuffer tmp( buf.getWritePos() );
-    size_t tgtPos = 0;
-    size_t count  = lineInfo.getCount();
+    size_t fill = buf.getWritePos();
+    if ( deadBytes == 0 || deadBytes * 100U < fill * compactRatio ) return;
+    size_t   count  = lineInfo.getCount();
+    LineRef* refs   = new LineRef [ count ? count : 1U ];
+    bool     sorted = true;
     for ( size_t pos=0; pos < count; ++pos ) {
-        LineInfo& li = lineInfo.getAt( pos );
-        buf.setReadPos( li.offset );
-        const uint8_t* ptr = buf.readBlock( li.length );
-        if ( ptr == 0 ) {
-            throw Exception( "compact error (type A)" );
-        }
-        li.offset = tgtPos;
-        if ( tmp.writeBlock( ptr, li.length ) ) {
-            tgtPos += li.length;
-        } else {
-            throw Exception( "compact error (type B)" );
-        }
+        refs[pos].offset = lineInfo.getAt( pos ).offset;
+        refs[pos].index  = (uint32_t) pos;
+        if ( pos && refs[pos].offset < refs[pos-1U].offset ) sorted = false;
     }
-    buf.setWritePos(0);
-    if ( tmp.getWritePos() > 0U ) {
-        buf.clrMemMgr(); // avoid recursion (*IF* that ever happens)
-        if ( !buf.writeBlock( tmp.getBaseAddr(), tmp.getWritePos() ) ) {
-            throw Exception( "compact error (type C)" );
+    if ( !sorted ) qsort( refs, count, sizeof(LineRef), cmpLineRef );
+    uint8_t* base   = buf.getBaseAddr();
+    size_t   tgtPos = 0;
+    for ( size_t pos=0; pos < count; ++pos ) {
+        LineInfo& li = lineInfo.getAt( refs[pos].index );
+        if ( li.offset + (size_t) li.length > fill ) {
+            delete [] refs;
+            throw Exception( "compact error: line outside of buffer" );
         }
-        buf.setMemMgr( *this );
+        if ( li.offset != tgtPos ) {
+            memmove( &base[tgtPos], &base[li.offset], li.length );
+            li.offset = (uint32_t) tgtPos;
+        }
+        tgtPos += li.length;
     }
+    delete [] refs;
+    buf.setWritePos( tgtPos );
+    deadBytes = 0;
 }
 
-Program::Program() : prg(MINPRGSIZE), lineInfo(MINLINEINFO) {
+LabelEnt::LabelEnt( const uint8_t* name_, size_t nameLen_, 
+    uint32_t lineNo_ ) : HashEntry( name_, nameLen_, HN_INLINE, 
+    sizeof(LabelEnt) ), lineNo(lineNo_), nDefs(1U) {}
+
+LabelEnt::~LabelEnt() {}
+
+LabelEnt* LabelEnt::create( const uint8_t* name_, size_t nameLen_, 
+    uint32_t lineNo_, HashArena* arena ) {
+    return new( HashInline( nameLen_, arena ) ) LabelEnt( name_, nameLen_, 
+        lineNo_ );
+}
+
+Program::Program() : prg(MINPRGSIZE), lineInfo(MINLINEINFO), deadBytes(0),
+    compactRatio(COMPACTRATIO), lineCode(0), jumpCache(0), codeValid(false),
+    labelsValid(true), image(0), imageSize(0) {
     prg.setMemMgr( *this );
 }
 
 Program::~Program() {
     prg.clrMemMgr();
+    if ( image ) munmap( image, imageSize );
+    image = 0; imageSize = 0;
+    delete [] jumpCache; jumpCache = 0;
+    delete [] lineCode; lineCode = 0;
+}
+
+void Program::prepareRun() {
+    if ( codeValid ) return;
+    size_t count = lineInfo.getCount();
+    delete [] jumpCache; jumpCache = 0;
+    delete [] lineCode;
+    lineCode = new size_t [ count + 1U ];
+    code.clear();
+    for ( size_t pos=0; pos < count; ++pos ) {
+        const LineInfo& li = lineInfo.getAt( pos );
+        lineCode[pos] = code.getCount();
+        if ( !code.append( prg.getBaseAddr() + li.offset ) ) {
+            throw Exception( "run error: bad token in line %lu", 
+                (unsigned long) li.lineNo );
+        }
+    }
+    lineCode[count] = code.getCount();
+    jumpCache = new uint32_t [ code.getCount() + 1U ];
+    memset( jumpCache, 0, sizeof(uint32_t) * ( code.getCount() + 1U ) );
+    // resolve label references once; a label first on the line (after
+    // the line number) is a definition
+    for ( size_t pos=0; pos < count; ++pos ) {
+        for ( size_t rec=lineCode[pos] + 2U; rec < lineCode[pos+1U]; ++rec ) {
+            const XTok* x = code.getAt( rec );
+            if ( x->tok != T_LABEL ) continue;
+            size_t line;
+            if ( !findLabel( x->text, x->len, line ) ) {
+                throw Exception( "undefined label %.*s in line %lu", 
+                    (int) x->len, (const char*) x->text, 
+                    (unsigned long) lineInfo.getAt( pos ).lineNo );
+            }
+            jumpCache[rec] = (uint32_t)( line + 1U );
+        }
+    }
+    codeValid = true;
+}
+
+// the label defined by a line, if any
+static bool lineLabel( const uint8_t* line, const uint8_t*& rName, 
+    uint8_t& rLen ) {
+    if ( line[0] != T_LINENO || line[4] != T_LABEL ) return false;
+    rLen  = line[5];
+    rName = line + 6;
+    return true;
+}
+
+void Program::addLabel( const uint8_t* line, uint32_t lineNo ) {
+    const uint8_t* name; uint8_t len;
+    if ( !lineLabel( line, name, len ) ) return;
+    LabelEnt* ent = (LabelEnt*) labels.find( name, len );
+    if ( ent == 0 ) {
+        labels.enter( LabelEnt::create( name, len, lineNo, 
+            labels.getArena() ) );
+        return;
+    }
+    ++ent->nDefs;
+    if ( lineNo < ent->lineNo ) ent->lineNo = lineNo;
+}
+
+void Program::remLabel( uint32_t lineNo ) {
+    size_t pos;
+    if ( !lineInfo.find( lineNo, pos ) ) return;
+    const uint8_t* name; uint8_t len;
+    if ( !lineLabel( prg.getBaseAddr() + lineInfo.getAt( pos ).offset, 
+        name, len ) ) return;
+    LabelEnt* ent = (LabelEnt*) labels.find( name, len );
+    if ( ent == 0 ) return;
+    if ( --ent->nDefs == 0 ) {
+        labels.remove( ent );
+        labels.release( ent );
+    } else if ( ent->lineNo == lineNo ) {
+        // which other line defines it is not known
+        labelsValid = false;
+    }
+}
+
+void Program::buildLabels() {
+    labels.clear();
+    const uint8_t* base  = prg.getBaseAddr();
+    size_t         count = lineInfo.getCount();
+    for ( size_t pos=0; pos < count; ++pos ) {
+        const LineInfo& li = lineInfo.getAt( pos );
+        addLabel( base + li.offset, li.lineNo );
+    }
+    labelsValid = true;
+}
+
+bool Program::findLabel( const uint8_t* name, size_t nameLen, 
+    size_t& rLine ) {
+    if ( !labelsValid ) buildLabels();
+    const LabelEnt* ent = (const LabelEnt*) labels.find( name, nameLen );
+    return ent != 0 && lineInfo.find( ent->lineNo, rLine );
+}
+
+bool Program::resolveJumpSlow( size_t rec, uint32_t lineNo, size_t& rLine ) {
+    size_t pos;
+    if ( !lineInfo.find( lineNo, pos ) ) return false;
+    jumpCache[rec] = (uint32_t)( pos + 1U );
+    rLine = pos;
+    return true;
+}
+
+// copy-on-write: moves the program out of the mapped image into own
+// memory, unless keep is false, and unmaps the image
+void Program::ownImage( bool keep ) {
+    if ( image == 0 ) return;
+    prg.own( MINPRGSIZE, keep );
+    lineInfo.own( keep );
+    munmap( image, imageSize );
+    image = 0; imageSize = 0;
 }
 
 void Program::enterLine( const Tokenizer& t ) {
+    codeValid = false;
+    ownImage( true );
     const uint8_t* addr = t.getTokBufAddr();
     size_t         size = t.getTokBufSz();
     TokenScanner scan( addr );
@@ -73,9 +224,12 @@ void Program::enterLine( const Tokenizer& t ) {
     tok = scan.tokType();
     if ( tok == T_EOL ) {
         // delete line
-        lineInfo.deleteLine( lineNo );
+        if ( labelsValid ) remLabel( lineNo );
+        deadBytes += lineInfo.deleteLine( lineNo );
         return;
     }
+    // make room first: compaction moves the write position
+    if ( !prg.reserve( size ) ) return;
 #if SIZE_MAX > UINT32_MAX
     if ( prg.getWritePos() > UINT32_MAX ) return;
 #endif
@@ -88,6 +242,474 @@ void Program::enterLine( const Tokenizer& t ) {
     if ( prg.getWritePos() > UINT32_MAX ) return;
 #endif
     li.length = ( (uint32_t) prg.getWritePos() ) - li.offset;
-    lineInfo.insert( li );
+    if ( labelsValid ) remLabel( lineNo );
+    deadBytes += lineInfo.insert( li );
+    if ( labelsValid ) addLabel( addr, lineNo );
+}
+
+void Program::renum( uint32_t newStart, uint32_t step, uint32_t oldStart ) {
+    size_t count = lineInfo.getCount();
+    size_t first;
+    lineInfo.find( oldStart, first );
+    if ( first == count ) return;
+    uint64_t last = newStart + (uint64_t) step * ( count - 1U - first );
+    if ( step == 0 || last > UINT24_MAX || 
+        ( first > 0 && lineInfo.getAt( first-1U ).lineNo >= newStart ) ) {
+        throw Exception( "RENUM error: line numbers out of range" );
+    }
+    codeValid = false;
+    ownImage( true );
+
+    // mapping pass: the new number of line pos is newNo[pos]; old 
+    // numbers stay in lineInfo for lookups until the rewrite is done
+    uint32_t* newNo = new uint32_t [ count ];
+    for ( size_t pos=0; pos < count; ++pos ) {
+        newNo[pos] = pos < first ? lineInfo.getAt( pos ).lineNo : 
+            newStart + step * (uint32_t)( pos - first );
+    }
+
+    // rewrite pass: every T_LINENO after the leading one is a reference,
+    // as the tokenizer only emits them after location keywords. All of
+    // them are 4 bytes, so they are patched in place.
+    uint8_t* base = prg.getBaseAddr();
+    for ( size_t pos=0; pos < count; ++pos ) {
+        uint8_t*     line = base + lineInfo.getAt( pos ).offset;
+        TokenScanner scan( line );
+        if ( !scan.skipTok() ) continue;
+        for ( uint16_t tok = scan.tokType(); tok != T_EOL; 
+            tok = scan.tokType() ) {
+            if ( tok == T_LINENO ) {
+                uint8_t* ref = (uint8_t*) scan.getPos();
+                size_t   target;
+                if ( lineInfo.find( loadBE24( ref + 1 ), target ) ) {
+                    storeBE24( ref + 1, newNo[target] );
+                }
+            }
+            if ( !scan.skipTok() ) break;
+        }
+    }
+    for ( size_t pos=first; pos < count; ++pos ) {
+        LineInfo& li = lineInfo.getAt( pos );
+        li.lineNo = newNo[pos];
+        storeBE24( base + li.offset + 1, li.lineNo );
+    }
+    lineInfo.lineNumbersChanged();
+    delete [] newNo;
+    labelsValid = false;
+}
+
+void Program::clear() {
+    codeValid = false;
+    ownImage( false );
+    prg.setWritePos( 0 );
+    lineInfo.clear();
+    labels.clear();
+    labelsValid = true;
+    deadBytes = 0;
+}
+
+// Tokenizes source lines into buf, appending one LineInfo per numbered 
+// line to lines in source order; a bare line number (delete request) is
+// recorded with length 0. Offsets are relative to buf. Returns false on 
+// error, with rSrcLine the failing line (1-based, within this source
+// range) and rErr the Tokenizer error or T_LINENO for a missing line 
+// number. On success, rSrcLine is the number of lines processed.
+static bool tokenizeLines( const uint8_t* source, size_t sourceLen, 
+    ByteBuffer& buf, LineInfoManager& lines, unsigned long& rSrcLine,
+    uint16_t& rErr ) {
+    Tokenizer      t( source, 0 );
+    const uint8_t* sourceEnd = source + sourceLen;
+    rSrcLine = 0;
+    while ( source < sourceEnd ) {
+        const uint8_t* eol = (const uint8_t*) memchr( source, '\n', 
+            sourceEnd - source );
+        if ( eol == 0 ) eol = sourceEnd;
+        t.reset( source, eol - source );
+        source = eol + 1;
+        ++rSrcLine;
+        size_t   start = buf.getWritePos();
+        uint16_t tok   = t.tokenize( buf );
+        if ( tok != T_EOL ) { rErr = tok; return false; }
+        TokenScanner scan( buf.getBaseAddr() + start );
+        tok = scan.tokType();
+        if ( tok == T_EOL ) {   // blank line
+            buf.setWritePos( start );
+            continue;
+        }
+        uint32_t lineNo;
+        if ( tok != T_LINENO || !scan.getLineNo( lineNo ) || 
+            !scan.skipTok() ) {
+            rErr = T_LINENO; return false;
+        }
+        LineInfo li;
+        li.lineNo = lineNo;
+        li.offset = (uint32_t) start;
+        if ( scan.tokType() == T_EOL ) {
+            buf.setWritePos( start );
+            li.length = 0;
+        } else {
+            li.length = (uint32_t)( buf.getWritePos() - start );
+        }
+        lines.append( li );
+    }
+    return true;
+}
+
+static void throwLoadError( uint16_t err, unsigned long srcLine ) {
+    if ( err == T_LINENO ) {
+        throw Exception( "load error: line number expected in line %lu",
+            srcLine );
+    }
+    throw Exception( "load error: syntax error (%d) in line %lu", 
+        (int) err, srcLine );
 }
 
+// a slice of the source, tokenized by a thread of its own
+struct LoadChunk : public NonCopyable {
+    const uint8_t*      source;
+    size_t              sourceLen;
+    ByteBuffer          buf;
+    LineInfoManager     lines;
+    unsigned long       nSrcLines;
+    uint16_t            err;
+    bool                ok;
+    pthread_t           thread;
+
+    LoadChunk( const uint8_t* source_, size_t sourceLen_ ) 
+        : source(source_), sourceLen(sourceLen_), 
+          buf( sourceLen_ + 16U ), lines(MINLINEINFO), nSrcLines(0),
+          err(0), ok(false) {}
+
+    static void* run( void* arg ) {
+        LoadChunk* c = (LoadChunk*) arg;
+        c->ok = tokenizeLines( c->source, c->sourceLen, c->buf, c->lines,
+            c->nSrcLines, c->err );
+        return 0;
+    }
+};
+
+// lines were tokenized at offset base of the program buffer. Sorted
+// lines (the usual case) are appended in one go.
+void Program::enterLines( LineInfoManager& lines, size_t base ) {
+    labelsValid = false;
+    size_t count = lines.getCount();
+    for ( size_t pos=0; pos < count; ++pos ) {
+        LineInfo& li = lines.getAt( pos );
+#if SIZE_MAX > UINT32_MAX
+        if ( base + li.offset + li.length > UINT32_MAX ) {
+            throw Exception( "load error: program too large" );
+        }
+#endif
+        li.offset += (uint32_t) base;
+    }
+    if ( count == 0 || lineInfo.bulkAppend( &lines.getAt( 0 ), count ) ) {
+        return;
+    }
+    for ( size_t pos=0; pos < count; ++pos ) {
+        const LineInfo& li = lines.getAt( pos );
+        if ( li.length == 0 ) {
+            deadBytes += lineInfo.deleteLine( li.lineNo );
+        } else {
+            deadBytes += lineInfo.insert( li );
+        }
+    }
+}
+
+void Program::load( const uint8_t* source, size_t sourceLen, 
+    int nThreads ) {
+    clear();
+    // compact() only knows about complete lines, so it must not run
+    // while a line is being tokenized into the buffer.
+    prg.clrMemMgr();
+    try {
+        if ( nThreads > 1 && sourceLen >= PARLOADMIN ) {
+            loadParallel( source, sourceLen, nThreads );
+        } else {
+            LineInfoManager lines( MINLINEINFO );
+            unsigned long   srcLine = 0;
+            uint16_t        err     = 0;
+            if ( !tokenizeLines( source, sourceLen, prg, lines, srcLine, 
+                err ) ) {
+                throwLoadError( err, srcLine );
+            }
+            enterLines( lines, 0 );
+        }
+    } catch ( const Exception& xcpt ) {
+        clear();
+        prg.setMemMgr( *this );
+        throw;
+    }
+    prg.setMemMgr( *this );
+}
+
+void Program::loadParallel( const uint8_t* source, size_t sourceLen, 
+    int nThreads ) {
+
+    // split at line boundaries into chunks of about the same size
+    LoadChunk**    chunks    = new LoadChunk* [ nThreads ];
+    const uint8_t* sourceEnd = source + sourceLen;
+    int nChunks = 0;
+    while ( source < sourceEnd && nChunks < nThreads ) {
+        size_t         want = ( sourceEnd - source ) / ( nThreads - nChunks );
+        const uint8_t* end  = source + want;
+        if ( nChunks == nThreads - 1 || end >= sourceEnd ) {
+            end = sourceEnd;
+        } else {
+            end = (const uint8_t*) memchr( end, '\n', sourceEnd - end );
+            end = end ? end + 1 : sourceEnd;
+        }
+        chunks[nChunks++] = new LoadChunk( source, end - source );
+        source = end;
+    }
+
+    // chunk 0 is done by this thread, the others by worker threads
+    int nStarted = 1;
+    for ( ; nStarted < nChunks; ++nStarted ) {
+        if ( pthread_create( &chunks[nStarted]->thread, 0, LoadChunk::run,
+            chunks[nStarted] ) != 0 ) break;
+    }
+    for ( int i=nStarted; i < nChunks; ++i ) LoadChunk::run( chunks[i] );
+    if ( nChunks > 0 ) LoadChunk::run( chunks[0] );
+    for ( int i=1; i < nStarted; ++i ) pthread_join( chunks[i]->thread, 0 );
+
+    // merge in source order, so that later lines replace earlier ones
+    unsigned long srcLine = 0;
+    int i = 0;
+    try {
+        for ( ; i < nChunks; ++i ) {
+            LoadChunk* c = chunks[i];
+            if ( !c->ok ) throwLoadError( c->err, srcLine + c->nSrcLines );
+            size_t base = prg.getWritePos();
+            if ( !prg.writeBlock( c->buf.getBaseAddr(), 
+                c->buf.getWritePos() ) ) {
+                throw Exception( "load error: out of memory" );
+            }
+            enterLines( c->lines, base );
+            srcLine += c->nSrcLines;
+            delete c; 
+        }
+    } catch ( const Exception& xcpt ) {
+        for ( ; i < nChunks; ++i ) delete chunks[i];
+        delete [] chunks;
+        throw;
+    }
+    delete [] chunks;
+}
+
+// Fletcher-style sum over 64-bit words; a partial last word is padded
+// with zero bytes
+static void imageSum( const uint8_t* p, size_t len, uint64_t& a, 
+    uint64_t& b ) {
+    const uint8_t* end = p + ( len & ~(size_t) 7U );
+    for ( ; p < end; p += 8 ) {
+        uint64_t w; memcpy( &w, p, 8U );
+        a += w; b += a;
+    }
+    if ( len & 7U ) {
+        uint64_t w = 0; memcpy( &w, p, len & 7U );
+        a += w; b += a;
+    }
+}
+
+static uint64_t imageChecksum( const uint8_t* info, size_t infoLen,
+    const uint8_t* code, size_t codeLen ) {
+    uint64_t a = UINT64_C(1), b = 0;
+    imageSum( info, infoLen, a, b );
+    imageSum( code, codeLen, a, b );
+    return ( b << 32 | b >> 32 ) ^ a;
+}
+
+// walks the tokens of an image line: it must start with its own line
+// number, and every token must end within the line, on its T_EOL
+static bool imageLineOk( const uint8_t* line, const LineInfo& li ) {
+    const uint8_t* eol = line + li.length - 1U;
+    uint32_t       lineNo;
+    TokenScanner   scan( line );
+    if ( li.length < 5U || !scan.getLineNo( lineNo ) || 
+        lineNo != li.lineNo ) return false;
+    while ( scan.getPos() < eol ) {
+        if ( !scan.skipTok() || scan.getPos() > eol ) return false;
+    }
+    return true;
+}
+
+void Program::loadImage( const char* fileName, int fd, size_t size ) {
+    void* map = mmap( 0, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( map == MAP_FAILED ) {
+        throw Exception( "load error: %s: %s", fileName, strerror(errno) );
+    }
+    // validate everything once, so that the image can be used as is
+    const ProgImageHeader* hdr  = (const ProgImageHeader*) map;
+    const LineInfo*        info = (const LineInfo*)( hdr + 1 );
+    size_t avail = size - sizeof(ProgImageHeader);
+    bool   ok    = hdr->version == PRGIMGVERSION && 
+                   hdr->byteOrder == PRGIMGBYTEORDER &&
+                   hdr->lineCount <= avail / sizeof(LineInfo) &&
+                   hdr->codeSize == avail - hdr->lineCount * sizeof(LineInfo)
+#if SIZE_MAX > UINT32_MAX
+                   && hdr->codeSize <= UINT32_MAX
+#endif
+                   ;
+    size_t         count = ok ? (size_t) hdr->lineCount : 0;
+    size_t         codeSize = ok ? (size_t) hdr->codeSize : 0;
+    const uint8_t* code  = (const uint8_t*)( info + count );
+    if ( ok ) {
+        ok = imageChecksum( (const uint8_t*) info, count * sizeof(LineInfo),
+            code, codeSize ) == hdr->checksum;
+    }
+    for ( size_t pos=0; ok && pos < count; ++pos ) {
+        const LineInfo& li = info[pos];
+        ok = li.length > 0 && li.offset < codeSize && 
+             li.length <= codeSize - li.offset &&
+             code[li.offset + li.length - 1U] == T_EOL &&
+             ( pos == 0 || li.lineNo > info[pos-1U].lineNo ) &&
+             imageLineOk( code + li.offset, li );
+    }
+    if ( !ok ) {
+        munmap( map, size );
+        throw Exception( "load error: %s: bad program image", fileName );
+    }
+    clear();
+    lineInfo.attach( info, count );
+    labelsValid = false;
+    prg.attach( (uint8_t*) code, codeSize );
+    image = map; imageSize = size;
+}
+
+void Program::load( const char* fileName, int nThreads ) {
+    int fd = open( fileName, O_RDONLY );
+    if ( fd < 0 ) {
+        throw Exception( "load error: %s: %s", fileName, strerror(errno) );
+    }
+    struct stat st;
+    char        magic[8];
+    if ( fstat( fd, &st ) == 0 && 
+        (size_t) st.st_size >= sizeof(ProgImageHeader) &&
+        pread( fd, magic, 8U, 0 ) == 8 && 
+        memcmp( magic, PRGIMGMAGIC, 8U ) == 0 ) {
+        try {
+            loadImage( fileName, fd, (size_t) st.st_size );
+        } catch ( const Exception& xcpt ) {
+            close( fd );
+            throw;
+        }
+        close( fd );
+        return;
+    }
+    close( fd );
+    FILE* fp = fopen( fileName, "rb" );
+    if ( fp == 0 ) {
+        throw Exception( "load error: %s: %s", fileName, strerror(errno) );
+    }
+    long size = -1L;
+    if ( fseek( fp, 0L, SEEK_END ) == 0 ) size = ftell( fp );
+    if ( size < 0L || fseek( fp, 0L, SEEK_SET ) != 0 ) {
+        int err = errno;
+        fclose( fp );
+        throw Exception( "load error: %s: %s", fileName, strerror(err) );
+    }
+    uint8_t* buf = new uint8_t [ size + 1L ];
+    size_t   len = fread( buf, 1U, (size_t) size, fp );
+    fclose( fp );
+    if ( len != (size_t) size ) {
+        delete [] buf;
+        throw Exception( "load error: %s: read error", fileName );
+    }
+    try {
+        load( buf, len, nThreads );
+    } catch ( const Exception& xcpt ) {
+        delete [] buf;
+        throw;
+    }
+    delete [] buf;
+}
+
+// a file written under a temporary name and renamed when complete, so
+// that a mapped image of the same file is never truncated under our feet
+struct SaveFile : public NonCopyable {
+    const char* fileName;
+    char*       tmpName;
+    FILE*       fp;
+
+    SaveFile( const char* fileName_ ) : fileName(fileName_) {
+        size_t nameLen = strlen( fileName );
+        tmpName = new char [ nameLen + 5U ];
+        memcpy( tmpName, fileName, nameLen );
+        memcpy( tmpName + nameLen, ".tmp", 5U );
+        fp = fopen( tmpName, "wb" );
+        if ( fp == 0 ) {
+            int err = errno;
+            delete [] tmpName;
+            throw Exception( "save error: %s: %s", fileName, strerror(err) );
+        }
+    }
+
+    ~SaveFile() {
+        if ( fp ) { fclose( fp ); remove( tmpName ); }
+        delete [] tmpName;
+    }
+
+    // closes the file and, if ok, renames it. Throws Exception on error.
+    void commit( bool ok ) {
+        if ( fclose( fp ) != 0 ) ok = false;
+        fp = 0;
+        if ( ok && rename( tmpName, fileName ) != 0 ) ok = false;
+        if ( !ok ) {
+            remove( tmpName );
+            throw Exception( "save error: %s: write error", fileName );
+        }
+    }
+};
+
+void Program::save( const char* fileName ) {
+    size_t count    = lineInfo.getCount();
+    size_t codeSize = 0;
+    for ( size_t pos=0; pos < count; ++pos ) {
+        codeSize += lineInfo.getAt( pos ).length;
+    }
+    // lay out the image in memory: lines in order, without dead bytes
+    size_t   infoSize = count * sizeof(LineInfo);
+    size_t   size     = sizeof(ProgImageHeader) + infoSize + codeSize;
+    uint8_t* buf      = new uint8_t [ size ];
+    memset( buf, 0, sizeof(ProgImageHeader) + infoSize );
+    ProgImageHeader* hdr  = (ProgImageHeader*) buf;
+    LineInfo*        info = (LineInfo*)( hdr + 1 );
+    uint8_t*         code = (uint8_t*)( info + count );
+    const uint8_t*   src  = prg.getBaseAddr();
+    size_t           off  = 0;
+    for ( size_t pos=0; pos < count; ++pos ) {
+        const LineInfo& li = lineInfo.getAt( pos );
+        info[pos].lineNo = li.lineNo;
+        info[pos].offset = (uint32_t) off;
+        info[pos].length = li.length;
+        memcpy( code + off, src + li.offset, li.length );
+        off += li.length;
+    }
+    memcpy( hdr->magic, PRGIMGMAGIC, 8U );
+    hdr->version   = PRGIMGVERSION;
+    hdr->byteOrder = PRGIMGBYTEORDER;
+    hdr->lineCount = count;
+    hdr->codeSize  = codeSize;
+    hdr->checksum  = imageChecksum( (const uint8_t*) info, infoSize, 
+        code, codeSize );
+
+    SaveFile file( fileName );
+    bool ok = fwrite( buf, 1U, size, file.fp ) == size;
+    delete [] buf;
+    file.commit( ok );
+}
+
+void Program::saveText( const char* fileName ) {
+    SaveFile file( fileName );
+    bool ok = true;
+    {
+        DetokWriter    w( file.fp );
+        const uint8_t* base  = prg.getBaseAddr();
+        size_t         count = lineInfo.getCount();
+        for ( size_t pos=0; ok && pos < count; ++pos ) {
+            ok = w.writeLine( base + lineInfo.getAt( pos ).offset );
+        }
+        if ( !w.flush() ) ok = false;
+    }
+    file.commit( ok );
+}
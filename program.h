@@ -31,16 +31,95 @@
 #include "tokenizer.h"
 #endif
 
+#ifndef TOKENSTREAM_H
+#include "tokenstream.h"
+#endif
+
+#ifndef HASHTABLE_H
+#include "hashtable.h"
+#endif
+
 // initial program buffer size
 #define MINPRGSIZE        16384U
 
+// percentage of dead bytes (left by replaced and deleted lines) at
+// which the program buffer is compacted when full, instead of grown
+#define COMPACTRATIO      25U
+
+// smallest source text loaded with several threads
+#define PARLOADMIN        262144U
+
+// program image file: this header, then LineInfo[lineCount] with 
+// offsets relative to the code, then codeSize bytes of compacted code.
+// All fields are in host byte order; byteOrder tells if it matches.
+#define PRGIMGMAGIC       "PRIBIMG\032"
+#define PRGIMGVERSION     1U
+#define PRGIMGBYTEORDER   UINT32_C(0X01020304)
+
+struct ProgImageHeader {
+    char        magic[8];   // PRGIMGMAGIC
+    uint32_t    version;    // PRGIMGVERSION
+    uint32_t    byteOrder;  // PRGIMGBYTEORDER
+    uint64_t    lineCount;  // number of LineInfo entries
+    uint64_t    codeSize;   // code bytes
+    uint64_t    checksum;   // over LineInfo entries and code
+    uint64_t    reserved;   // (0)
+};
+
+// a label, defined by "name:" first on a line
+struct LabelEnt : public HashEntry {
+    uint32_t    lineNo;     // lowest line defining it
+    uint32_t    nDefs;      // number of lines defining it
+
+    virtual ~LabelEnt();
+
+    static LabelEnt* create( const uint8_t* name_, size_t nameLen_, 
+        uint32_t lineNo_, HashArena* arena );
+
+private:
+    LabelEnt( const uint8_t* name_, size_t nameLen_, uint32_t lineNo_ );
+};
+
 class Program : public NonCopyable, protected BBMemMan {
 
     ByteBuffer      prg;
     LineInfoManager lineInfo;
+    size_t          deadBytes;      // bytes not referenced by lineInfo
+    unsigned        compactRatio;   // see COMPACTRATIO
+
+    // the program decoded for execution, see prepareRun()
+    TokenStream     code;
+    size_t*         lineCode;       // first record of each line
+    uint32_t*       jumpCache;      // per record: target line index + 1
+    bool            codeValid;      // false after every edit
+
+    // label index, kept up to date by enterLine(); rebuilt on demand
+    // after loading or when a duplicate label loses its lowest line.
+    // Edits remove single entries, so it lives on the heap, not in an
+    // arena
+    HashTable       labels;
+    bool            labelsValid;
+
+    // a loaded program image, mapped read-only and used in place by 
+    // prg and lineInfo until the first change, see ownImage()
+    void*           image;
+    size_t          imageSize;
+
+    void addLabel( const uint8_t* line, uint32_t lineNo );
+    void remLabel( uint32_t lineNo );   // of the present line lineNo
+    void buildLabels();
+
+    void ownImage( bool keep );
+    void loadImage( const char* fileName, int fd, size_t size );
+
+    bool resolveJumpSlow( size_t rec, uint32_t lineNo, size_t& rLine );
 
     virtual void compact( ByteBuffer& buf );
 
+    void enterLines( LineInfoManager& lines, size_t base );
+    void loadParallel( const uint8_t* source, size_t sourceLen, 
+        int nThreads );
+
 public:
     Program();
     virtual ~Program();
@@ -53,6 +132,19 @@ public:
         return lineInfo.getAt( pos );
     }
 
+    // see LineInfoManager::find()
+    inline bool findLine( uint32_t lineNo, size_t& rPos ) const {
+        return lineInfo.find( lineNo, rPos );
+    }
+
+    inline size_t getSize() const { return prg.getWritePos(); }
+    inline size_t getDeadBytes() const { return deadBytes; }
+
+    // percentage of dead bytes required for compaction (0 = any)
+    inline void setCompactRatio( unsigned percent ) {
+        compactRatio = percent;
+    }
+
     inline void setReadPos( size_t pos ) {
         prg.setReadPos( pos );
     }
@@ -63,6 +155,69 @@ public:
 
     void enterLine( const Tokenizer& t );
 
+    // decodes the whole program unless that has already been done since
+    // the last edit, and resolves all label references. Throws Exception
+    // on a malformed line or an undefined label.
+    void prepareRun();
+
+    inline bool isCodeValid() const { return codeValid; }
+
+    // execution stream of a line, after prepareRun()
+    inline const XTok* getLineCode( size_t line ) const {
+        return code.getAt( lineCode[line] );
+    }
+
+    // position of a record of the execution stream
+    inline size_t getCodeIndex( const XTok* x ) const {
+        return x - code.getAt( 0 );
+    }
+
+    // finds the line index of lineNo for a jump whose T_LINENO is 
+    // record rec. The result is cached per record until the next edit.
+    inline bool resolveJump( size_t rec, uint32_t lineNo, size_t& rLine ) {
+        uint32_t target = jumpCache[rec];
+        if ( target ) { rLine = target - 1U; return true; }
+        return resolveJumpSlow( rec, lineNo, rLine );
+    }
+
+    // finds the line index of the line defining a label
+    bool findLabel( const uint8_t* name, size_t nameLen, size_t& rLine );
+
+    // like resolveJump(), for a label. After prepareRun(), every label
+    // reference is already resolved.
+    inline bool resolveLabel( size_t rec, const uint8_t* name, 
+        size_t nameLen, size_t& rLine ) {
+        uint32_t target = jumpCache[rec];
+        if ( target ) { rLine = target - 1U; return true; }
+        return findLabel( name, nameLen, rLine );
+    }
+
+    // renumbers the lines from oldStart on to newStart, newStart + step,
+    // ..., and rewrites every line number reference (after GOTO, GOSUB,
+    // THEN etc.) in place. References to missing lines are left as is.
+    // Throws Exception if the new numbers would not fit.
+    void renum( uint32_t newStart, uint32_t step, uint32_t oldStart );
+
+    // removes all lines
+    void clear();
+
+    // replaces the program by an ASCII source text, one numbered line
+    // per text line. Lines are tokenized straight into the program 
+    // buffer. Throws Exception on error, leaving the program empty.
+    // With nThreads > 1, large sources are split at line boundaries 
+    // and tokenized concurrently; the result is the same.
+    void load( const uint8_t* source, size_t sourceLen, int nThreads = 1 );
+    // loads an ASCII source file (see above) or a program image
+    // written by save(). An image is mapped into memory and used in 
+    // place; it is only copied when the program is changed.
+    void load( const char* fileName, int nThreads = 1 );
+
+    // writes the program as a program image. Throws Exception on error.
+    void save( const char* fileName );
+
+    // writes the program as ASCII source text, as LIST shows it
+    void saveText( const char* fileName );
+
 };
 
 #endif
@@ -21,6 +21,9 @@
         Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
 
 #include "hashtable.h"
+#include "keywords.h"
+
+#include <malloc.h>
 
 #define TESTNODES       1000000
 #define MINNAME         5U
@@ -78,6 +81,53 @@ static size_t randName( uint8_t* buf, size_t bufsz ) {
     return reqlen;
 }
 
+// heap bytes, lookup and teardown time per entry, for each way of 
+// holding names and entries
+static void nameModes( const uint8_t* names, const size_t* nameLens ) {
+    static const struct { 
+        const char* title; HashNameMode mode; bool arena; 
+    } modes[] = {
+        { "copied",   HN_COPY,   false },
+        { "inline",   HN_INLINE, false },
+        { "borrowed", HN_BORROW, false },
+        { "arena",    HN_INLINE, true  },
+    };
+    for ( size_t m=0; m < sizeof(modes)/sizeof(modes[0]); ++m ) {
+        HashNameMode mode = modes[m].mode;
+        size_t       mem0 = mallinfo2().uordblks;
+        HashTable*   ht   = new HashTable( modes[m].arena );
+        for ( int i=0; i < TESTNODES; ++i ) {
+            const uint8_t* name = names + (size_t) i * MAXNAME;
+            if ( ht->find( name, nameLens[i] ) ) continue;
+            if ( mode == HN_INLINE ) {
+                ht->enter( new( HashInline( nameLens[i], ht->getArena() ) ) 
+                    HashEntry( name, nameLens[i], HN_INLINE, 
+                        sizeof(HashEntry) ) );
+            } else {
+                ht->enter( new HashEntry( name, nameLens[i], mode, 
+                    sizeof(HashEntry) ) );
+            }
+        }
+        size_t mem1 = mallinfo2().uordblks;
+        double ti0  = getTime();
+        // in scattered order, so that the entries aren't met in turn
+        for ( int i=0; i < TESTNODES; ++i ) {
+            size_t k = (size_t) i * 7919U % TESTNODES;
+            ht->find( names + k * MAXNAME, nameLens[k] );
+        }
+        double ti1  = getTime();
+        size_t n    = ht->getCount();
+        ht->clear();
+        double ti2  = getTime();
+        printf( "%-8s names: %.1f MB per million entries "
+            "(%.1f bytes each), %.1f ns/lookup, clear %.1f ms\n", 
+            modes[m].title, ( mem1 - mem0 ) / 1048576.0 * 1000000.0 / n,
+            ( mem1 - mem0 ) / (double) n, ( ti1 - ti0 ) * 1E9 / TESTNODES,
+            ( ti2 - ti1 ) * 1E3 );
+        delete ht;
+    }
+}
+
 int main( int argc, char** argv ) {
 
     fp_rand = fopen( "/dev/urandom", "rb" );
@@ -86,34 +136,129 @@ int main( int argc, char** argv ) {
         return EXIT_FAILURE;
     }
 
+    // names first, so that only the table is timed
+    uint8_t* names    = new uint8_t [ (size_t) TESTNODES * MAXNAME ];
+    size_t*  nameLens = new size_t [ TESTNODES ];
+    for ( int i=0; i < TESTNODES; ++i ) {
+        nameLens[i] = randName( names + (size_t) i * MAXNAME, MAXNAME );
+    }
+
+    nameModes( names, nameLens );
+
     HashTable ht;
+    int nAdded = 0;
 
     double ti0 = getTime();
 
     for ( int i=0; i < TESTNODES; ++i ) {
+        const uint8_t* name = names + (size_t) i * MAXNAME;
+        if ( ht.find( name, nameLens[i] ) ) continue;   // duplicate
+        ht.enter( new HashEntry( name, nameLens[i] ) );
+        ++nAdded;
+    }
 
-        uint8_t name[MAXNAME];
-        size_t nameLen;
+    double ti1 = getTime();
 
-        do {
-            nameLen = randName( name, sizeof(name) );
-        } while ( ht.find( name, nameLen ) );
+    size_t found = 0;
+    for ( int i=0; i < TESTNODES; ++i ) {
+        if ( ht.find( names + (size_t) i * MAXNAME, nameLens[i] ) ) ++found;
+    }
 
-        HashEntry* ent = new HashEntry( name, nameLen );
-        ht.enter( ent );
+    double ti2 = getTime();
 
+    // misses: the same names, one character longer
+    size_t missed = 0;
+    for ( int i=0; i < TESTNODES; ++i ) {
+        uint8_t* name = names + (size_t) i * MAXNAME;
+        name[nameLens[i]] = '_';
+        if ( !ht.find( name, nameLens[i] + 1U ) ) ++missed;
     }
 
-    double ti1 = getTime();
-    double dif = ti1 - ti0;
+    double ti3 = getTime();
+
+    printf( "%d nodes added in %g seconds (%.0f inserts/s)\n", nAdded,
+        ti1 - ti0, nAdded / ( ti1 - ti0 ) );
+    printf( "%lu of %d found in %g seconds (%.0f lookups/s)\n",
+        (unsigned long) found, TESTNODES, ti2 - ti1, 
+        TESTNODES / ( ti2 - ti1 ) );
+    printf( "%lu of %d missed in %g seconds (%.0f lookups/s)\n",
+        (unsigned long) missed, TESTNODES, ti3 - ti2, 
+        TESTNODES / ( ti3 - ti2 ) );
+    printf( "%lu slots, load %.1f%%, probe length %.2f average, %lu max\n",
+        (unsigned long) ht.getSize(), 
+        ht.getCount() * 100.0 / ht.getSize(), ht.avgProbe(),
+        (unsigned long) ht.maxProbe() );
+
+    // distribution of the same names over the same slots
+    static const struct { const char* name; HashFunc func; } hashes[] = {
+        { "hashName",   HashTable::hashName   },
+        { "legacyHash", HashTable::legacyHash },
+    };
+    for ( size_t i=0; i < sizeof(hashes)/sizeof(hashes[0]); ++i ) {
+        HashStats st;
+        ht.coverage( hashes[i].func, st );
+        printf( "%-10s: %.1f%% coverage, chi-square %.3f, max %lu per slot, "
+            "%lu equal 32-bit hashes\n", hashes[i].name, st.coverage, 
+            st.chiSquare, (unsigned long) st.maxCount, 
+            (unsigned long) st.dupHashes );
+    }
 
-    printf( "%ld nodes added in %g seconds\n", (long) TESTNODES,
-        dif );
+    // take every other entry out again; the random names may repeat,
+    // so the removed ones are remembered (by borrowing their names)
+    HashTable gone;
+    for ( int i=0; i < TESTNODES; i += 2 ) {
+        const uint8_t* name = names + (size_t) i * MAXNAME;
+        HashEntry* ent = ht.find( name, nameLens[i] );
+        if ( ent ) { ht.remove( ent ); delete ent; }
+        if ( !gone.find( name, nameLens[i] ) ) {
+            gone.enter( new HashEntry( name, nameLens[i], HN_BORROW, 
+                sizeof(HashEntry) ) );
+        }
+    }
+    for ( int i=0; i < TESTNODES; ++i ) {
+        const uint8_t* name = names + (size_t) i * MAXNAME;
+        HashEntry* ent = ht.find( name, nameLens[i] );
+        if ( ( ent != 0 ) == ( gone.find( name, nameLens[i] ) != 0 ) ) {
+            fprintf( stderr, "entry %d wrong after removal\n", i );
+            return EXIT_FAILURE;
+        }
+    }
+    printf( "%lu nodes left after removal\n", (unsigned long) ht.getCount() );
+
+    // remove() takes out the very entry given, also with equal names
+    {
+        HashTable  dup;
+        HashEntry* older = new HashEntry( (const uint8_t*) "same", 4U );
+        HashEntry* newer = new HashEntry( (const uint8_t*) "same", 4U );
+        dup.enter( older );
+        dup.enter( newer );
+        dup.remove( newer );
+        bool ok = dup.getCount() == 1U && 
+            dup.find( (const uint8_t*) "same", 4U ) == older;
+        dup.remove( older );
+        ok = ok && dup.getCount() == 0 && 
+            dup.find( (const uint8_t*) "same", 4U ) == 0;
+        delete newer; delete older;
+        if ( !ok ) {
+            fprintf( stderr, "wrong entry removed for equal names\n" );
+            return EXIT_FAILURE;
+        }
+    }
 
-    double cov = ht.coverage();
-    printf( "coverage is %g%%\n", cov );
+    // Keywords::add() replaces an earlier definition of the same name
+    {
+        Keywords& kw = Keywords::getInstance();
+        kw.add( (const uint8_t*) "TESTKW", 6U, UINT16_C(0X0EF0) );
+        kw.add( (const uint8_t*) "TESTKW", 6U, UINT16_C(0X0EF1) );
+        if ( kw.lookup( (const uint8_t*) "TESTKW", 6U ) != 
+            UINT16_C(0X0EF1) ) {
+            fprintf( stderr, "keyword not redefined\n" );
+            return EXIT_FAILURE;
+        }
+    }
 
-    ht.dumpCounts();
+    delete [] nameLens;
+    delete [] names;
 
     fclose( fp_rand );
 
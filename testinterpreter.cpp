@@ -22,8 +22,278 @@
 
 #include "interpreter.h"
 
+#include <unistd.h>
+
+#define TESTOUTSZ       65536
+
+// a script (lines separated by newlines) and the output it must give
+struct ScriptTest {
+    const char* title;
+    const char* script;
+    const char* expected;
+};
+
+static const ScriptTest scriptTests[] = {
+    { "GOSUB nesting",
+      "10 GOSUB 100\n20 PRINT \"back\"\n30 END\n"
+      "100 PRINT \"a\" : GOSUB 200 : PRINT \"b\"\n110 RETURN\n"
+      "200 PRINT \"c\" : RETURN\nRUN",
+      "a\nc\nb\nback\n" },
+    { "GOSUB too deep",
+      "10 GOSUB 10\nRUN",
+      "? GOSUB nesting too deep in line 10\n" },
+    { "RETURN without GOSUB",
+      "RETURN\n10 PRINT 1 : RETURN\nRUN",
+      "? RETURN without GOSUB\n1\n? RETURN without GOSUB in line 10\n" },
+    { "GOTO missing line",
+      "10 GOTO 55\n55 PRINT 55\nRUN\n20 GOTO 77\nRUN 20\nGOTO 78",
+      "55\n? undefined line number 77 in line 20\n"
+      "? undefined line number 78\n" },
+    { "GOTO backwards",
+      "10 LET I = 0\n20 LET I = I + 1\n30 IF I < 3 THEN 20\n"
+      "40 PRINT I\nRUN",
+      "3\n" },
+    { "IF falls through",
+      "10 IF 0 THEN 40\n20 PRINT \"fell\"\n"
+      "30 IF 0 THEN PRINT \"no\" : PRINT \"nor\"\n"
+      "40 IF 1 THEN PRINT \"yes\" : PRINT \"also\"\nRUN",
+      "fell\nyes\nalso\n" },
+    { "END and STOP",
+      "10 PRINT 1 : STOP : PRINT 2\n20 PRINT 3\nRUN\n"
+      "10 PRINT 4 : END\nRUN\nPRINT 5",
+      "1\n4\n5\n" },
+    { "RUN from a line",
+      "10 PRINT 10\n20 PRINT 20\n30 PRINT 30\nRUN 20\nRUN 25",
+      "20\n30\n? undefined line number 25\n" },
+    { "edit after RUN",
+      "10 PRINT 1\n20 GOTO 40\n30 PRINT 3\n40 PRINT 4\nRUN\n"
+      "20 GOTO 30\nRUN",
+      "1\n4\n1\n3\n4\n" },
+    { "labels as targets",
+      "10 GOSUB helper\n20 GOTO done\n30 PRINT \"skipped\"\n"
+      "40 done: PRINT \"done\" : END\n"
+      "50 helper: PRINT \"helper\" : RETURN\nRUN\nRUN helper\n"
+      "GOTO done",
+      "helper\ndone\nhelper\n? RETURN without GOSUB in line 50\n"
+      "done\n" },
+    { "duplicate label",
+      "10 GOTO dup\n20 dup: PRINT 20 : END\n30 dup: PRINT 30 : END\n"
+      "RUN\n20 PRINT \"no label\"\nRUN",
+      "20\n30\n" },
+    { "undefined label",
+      "10 GOTO nowhere\nRUN\nGOTO nowhere\n20 IF 1 THEN nowhere\n"
+      "10\nRUN",
+      "? undefined label NOWHERE in line 10\n"
+      "? undefined label NOWHERE\n"
+      "? undefined label NOWHERE in line 20\n" },
+    { "labels after edits",
+      "10 GOTO lbl\n20 lbl: PRINT 20 : END\nRUN\n"
+      "20 PRINT 21 : END\nRUN\n30 lbl: PRINT 30 : END\nRUN\n"
+      "5 lbl: PRINT 5 : END\nRUN 10\n5\nRUN\n30\nRUN",
+      "20\n? undefined label LBL in line 10\n30\n5\n30\n"
+      "? undefined label LBL in line 10\n" },
+    { "RENUM references",
+      "1 GOTO 7\n3 PRINT \"back\" : END\n5 GOTO 999\n"
+      "7 GOSUB 9 : GOTO 3\n9 IF 1 THEN 11\n11 PRINT \"sub\" : RETURN\n"
+      "RENUM\nLIST\nRUN\nRUN 30\nRENUM 100, 5, 40\nLIST\nRUN\n"
+      "RENUM 5, 10, 20",
+      " 10 GOTO 40\n 20 PRINT \"back\" : END\n 30 GOTO 999\n"
+      " 40 GOSUB 50 : GOTO 20\n 50 IF 1 THEN 60\n"
+      " 60 PRINT \"sub\" : RETURN\n"
+      "sub\nback\n? undefined line number 999 in line 30\n"
+      " 10 GOTO 100\n 20 PRINT \"back\" : END\n 30 GOTO 999\n"
+      " 100 GOSUB 105 : GOTO 20\n 105 IF 1 THEN 110\n"
+      " 110 PRINT \"sub\" : RETURN\n"
+      "sub\nback\n? RENUM error: line numbers out of range\n" },
+    { 0, 0, 0 }
+};
+
+static char testOut[TESTOUTSZ];
+
+// runs the lines of script on intp, and returns what they printed
+static const char* capture( Interpreter& intp, const char* script ) {
+    fflush( stdout );
+    FILE* tmp = tmpfile();
+    if ( tmp == 0 ) {
+        fprintf( stderr, "failed to create a temporary file: %m\n" );
+        exit( EXIT_FAILURE );
+    }
+    int saved = dup( 1 );
+    dup2( fileno( tmp ), 1 );
+    char line[1024];
+    for ( const char* p = script; *p; ) {
+        const char* e   = strchr( p, '\n' );
+        size_t      len = e ? (size_t)( e - p ) : strlen( p );
+        if ( len >= sizeof(line) ) len = sizeof(line) - 1U;
+        memcpy( line, p, len ); line[len] = '\0';
+        try {
+            intp.interpretLine( line );
+        }
+        catch ( const Exception& xcpt ) {
+            printf( "? %s\n", xcpt.what() );
+        }
+        p = e ? e + 1 : p + len;
+    }
+    fflush( stdout );
+    dup2( saved, 1 ); close( saved );
+    rewind( tmp );
+    size_t n = fread( testOut, 1U, TESTOUTSZ - 1U, tmp );
+    testOut[n] = '\0';
+    fclose( tmp );
+    return testOut;
+}
+
+static bool expect( const char* title, Interpreter& intp, 
+    const char* script, const char* expected ) {
+    const char* out = capture( intp, script );
+    if ( strcmp( out, expected ) == 0 ) return true;
+    fprintf( stderr, "test '%s' failed\n--- expected:\n%s--- got:\n%s",
+        title, expected, out );
+    return false;
+}
+
+// --- program images -----------------------------------------------------
+
+static const char imgProgram[] = 
+    "10 LET A = 5\n20 PRINT A, \"abc\"\n30 GOTO 50\n"
+    "40 PRINT \"skipped\"\n50 PRINT 1.5";
+
+static const char imgListing[] =
+    " 10 LET A = 5\n 20 PRINT A , \"abc\"\n 30 GOTO 50\n"
+    " 40 PRINT \"skipped\"\n 50 PRINT 1.5\n";
+
+// the image checksum, computed independently of program.cpp
+static void imgSum( const uint8_t* p, size_t len, uint64_t& a, 
+    uint64_t& b ) {
+    for ( size_t i=0; i < len; i += 8U ) {
+        uint64_t w = 0;
+        memcpy( &w, p + i, len - i < 8U ? len - i : 8U );
+        a += w; b += a;
+    }
+}
+
+// writes a changed copy of an image, with a fixed-up checksum
+static bool writeImage( const char* fileName, uint8_t* img, size_t len,
+    bool fixSum ) {
+    ProgImageHeader* hdr = (ProgImageHeader*) img;
+    if ( fixSum ) {
+        size_t   infoLen = (size_t) hdr->lineCount * sizeof(LineInfo);
+        uint64_t a = 1U, b = 0;
+        imgSum( img + sizeof(ProgImageHeader), infoLen, a, b );
+        imgSum( img + sizeof(ProgImageHeader) + infoLen, 
+            (size_t) hdr->codeSize, a, b );
+        hdr->checksum = ( b << 32 | b >> 32 ) ^ a;
+    }
+    FILE* fp = fopen( fileName, "wb" );
+    if ( fp == 0 ) return false;
+    bool ok = fwrite( img, len, 1U, fp ) == 1U;
+    return fclose( fp ) == 0 && ok;
+}
+
+static bool imageTests() {
+    char imgName[64], badName[64], script[256], expected[256];
+    snprintf( imgName, sizeof(imgName), "/tmp/pribtest%d.img", 
+        (int) getpid() );
+    snprintf( badName, sizeof(badName), "/tmp/pribtest%d.bad", 
+        (int) getpid() );
+    bool ok = true;
+
+    // SAVE and LOAD, then an edit of the mapped program
+    {
+        Interpreter intp;
+        snprintf( script, sizeof(script), "%s\nSAVE \"%s\"", imgProgram,
+            imgName );
+        if ( !expect( "image SAVE", intp, script, "" ) ) return false;
+    }
+    {
+        Interpreter intp;
+        snprintf( script, sizeof(script), "LOAD \"%s\"\nLIST\nRUN\n"
+            "15 PRINT 0\n40\nRUN", imgName );
+        snprintf( expected, sizeof(expected), "%s5\tabc\n1.5\n"
+            "0\n5\tabc\n1.5\n", imgListing );
+        if ( !expect( "image LOAD", intp, script, expected ) ) ok = false;
+    }
+    {
+        Interpreter intp;
+        snprintf( script, sizeof(script), "10 LOAD \"%s\" : PRINT 2\n"
+            "RUN\nLIST", imgName );
+        snprintf( expected, sizeof(expected), "? LOAD error: program is "
+            "running in line 10\n 10 LOAD \"%s\" : PRINT 2\n", imgName );
+        if ( !expect( "LOAD while running", intp, script, expected ) ) {
+            ok = false;
+        }
+    }
+
+    // damaged images must be refused, leaving the program as it was
+    FILE* fp = fopen( imgName, "rb" );
+    if ( fp == 0 ) { fprintf( stderr, "%s: %m\n", imgName ); return false; }
+    uint64_t origBuf[512], imgBuf[512];    // aligned for the header
+    uint8_t* orig = (uint8_t*) origBuf;
+    uint8_t* img  = (uint8_t*) imgBuf;
+    size_t   len  = fread( orig, 1U, sizeof(origBuf), fp );
+    fclose( fp );
+    ProgImageHeader* hdr  = (ProgImageHeader*) img;
+    LineInfo*        info = (LineInfo*)( hdr + 1 );
+    for ( int t=0; t < 4; ++t ) {
+        static const char* const what[] = {
+            "bad checksum", "truncated token", "line out of order",
+            "line number mismatch"
+        };
+        memcpy( img, orig, len );
+        uint8_t* code = (uint8_t*)( info + hdr->lineCount );
+        bool fixSum = true;
+        switch ( t ) {
+            case 0:     // any changed byte
+                code[ info[1].offset + 5U ] ^= UINT8_C(0X01);
+                fixSum = false;
+                break;
+            case 1: {   // "abc" claims to be longer than its line
+                uint8_t* p = (uint8_t*) memmem( code, (size_t) hdr->codeSize,
+                    "\x07\x03" "abc", 5U );
+                if ( p ) p[1] = UINT8_C(0X7F);
+                break;
+            }
+            case 2:     // line 20 becomes line 5, after line 10
+                info[1].lineNo = 5U;
+                storeBE24( &code[ info[1].offset + 1U ], 5U );
+                break;
+            case 3:     // line 20 claims to be line 21
+                info[1].lineNo = 21U;
+                break;
+        }
+        if ( !writeImage( badName, img, len, fixSum ) ) {
+            fprintf( stderr, "%s: %m\n", badName );
+            return false;
+        }
+        Interpreter intp;
+        snprintf( script, sizeof(script), "10 PRINT 1\nLOAD \"%s\"\nLIST",
+            badName );
+        snprintf( expected, sizeof(expected), "? load error: %s: bad "
+            "program image\n 10 PRINT 1\n", badName );
+        if ( !expect( what[t], intp, script, expected ) ) ok = false;
+    }
+
+    unlink( badName );
+    unlink( imgName );
+    return ok;
+}
+
+// the built-in tests: quiet unless one fails
+static bool runTests() {
+    bool ok = true;
+    for ( int i=0; scriptTests[i].title; ++i ) {
+        Interpreter intp;
+        if ( !expect( scriptTests[i].title, intp, scriptTests[i].script,
+            scriptTests[i].expected ) ) ok = false;
+    }
+    if ( !imageTests() ) ok = false;
+    return ok;
+}
+
 int main( int argc, char** argv ) {
 
+    if ( !runTests() ) return EXIT_FAILURE;
+
     Interpreter intp;
     char buf[1024];
     while ( fgets( buf, sizeof(buf), stdin ) ) {
@@ -22,9 +22,83 @@
 
 #include "tokenizer.h"
 #include "detokenizer.h"
+#include "tokenscanner.h"
+
+// "THEN label" must give T_LABEL whatever blanks end the line (CRLF 
+// sources keep the CR)
+static bool checkThenLabel() {
+    static const char* const lines[] = {
+        "10 IF X THEN FOO",
+        "10 IF X THEN FOO\r",
+        "10 IF X THEN FOO \r\n",
+        "10 IF X THEN FOO: PRINT X",
+        0
+    };
+    for ( int i=0; lines[i]; ++i ) {
+        Tokenizer t( (const uint8_t*) lines[i], strlen( lines[i] ) );
+        if ( t.tokenize() != T_EOL ) return false;
+        TokenScanner scan( t.getTokBufAddr() );
+        bool found = false;
+        while ( scan.tokType() != T_EOL ) {
+            if ( scan.tokType() == T_LABEL ) found = true;
+            if ( !scan.skipTok() ) break;
+        }
+        if ( !found ) {
+            fprintf( stderr, "no label in test line %d\n", i );
+            return false;
+        }
+    }
+    return true;
+}
+
+// listing a line and tokenizing it again must give the same tokens:
+// a real literal must stay real (1E10 must not come back as 10000000000)
+static bool checkNumRoundTrip() {
+    static const char* const lines[] = {
+        "10 LET A = 1E10 / 3",
+        "20 LET A = 2E6 + 2.0 - 0.5 + 3.25E2",
+        "30 LET A = 1E23 + 1E300 + 1.5E16 + 123456789.0 - 4E-3",
+        "40 LET A = 0.1 + 1E-7 + 9007199254740993.0",
+        "50 LET A = 10000000000 + 5",
+        0
+    };
+    for ( int i=0; lines[i]; ++i ) {
+        Tokenizer t1( (const uint8_t*) lines[i], strlen( lines[i] ) );
+        if ( t1.tokenize() != T_EOL ) return false;
+        Detokenizer d( t1.getTokBufAddr() );
+        const char* text = d.detokenize();
+        if ( text == 0 ) return false;
+        Tokenizer t2( (const uint8_t*) text, strlen( text ) );
+        if ( t2.tokenize() != T_EOL ) return false;
+        bool same = t1.getTokBufSz() == t2.getTokBufSz();
+        // literal by literal: the same kind (integer or real subtype)
+        TokenScanner s1( t1.getTokBufAddr() ), s2( t2.getTokBufAddr() );
+        while ( same && s1.tokType() != T_EOL ) {
+            uint16_t tok = s1.tokType();
+            same = tok == s2.tokType();
+            if ( same && ( tok == T_NUMLIT || tok == T_SBI ) ) {
+                same = s1.isInt() == s2.isInt() && 
+                    s1.getPos()[1] == s2.getPos()[1];
+            }
+            if ( !s1.skipTok() || !s2.skipTok() ) break;
+        }
+        if ( same ) {
+            same = memcmp( t1.getTokBufAddr(), t2.getTokBufAddr(), 
+                t1.getTokBufSz() ) == 0;
+        }
+        if ( !same ) {
+            fprintf( stderr, "'%s' lists as '%s', which tokenizes "
+                "differently\n", lines[i], text );
+            return false;
+        }
+    }
+    return true;
+}
 
 int main( int argc, char** argv ) {
 
+    if ( !checkThenLabel() || !checkNumRoundTrip() ) return EXIT_FAILURE;
+
     char buf[1024];
     while ( fgets( buf, sizeof(buf), stdin ) ) {
 
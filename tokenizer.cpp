@@ -23,54 +23,261 @@
 #include "tokenizer.h"
 #include "keywords.h"
 
+// character classes (see charClass[])
+#define CC_UPPER        0X01    // A..Z
+#define CC_LOWER        0X02    // a..z
+#define CC_DIGIT        0X04    // 0..9
+#define CC_SPACE        0X08    // SP BS CR LF
+#define CC_ALPHA        ( CC_UPPER | CC_LOWER )
+#define CC_ALNUM        ( CC_ALPHA | CC_DIGIT )
+
+#define CUP CC_UPPER
+#define CLO CC_LOWER
+#define CDG CC_DIGIT
+#define CSP CC_SPACE
+
+static const uint8_t charClass[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0, CSP,   0, CSP,   0,   0, CSP,   0,   0,   // 00
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   // 10
+    CSP,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   // 20
+    CDG, CDG, CDG, CDG, CDG, CDG, CDG, CDG, CDG, CDG,   0,   0,   0,   0,   0,   0,   // 30
+      0, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP,   // 40
+    CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP, CUP,   0,   0,   0,   0,   0,   // 50
+      0, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO,   // 60
+    CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO, CLO,   0,   0,   0,   0,   0,   // 70
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   // 80
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   // 90
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   // A0
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   // B0
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   // C0
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   // D0
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   // E0
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0    // F0
+};
+
+#undef CSP
+#undef CDG
+#undef CLO
+#undef CUP
+
+// actions taken by nextTok() on the first character of a token
+enum CharAction {
+    CA_SYN,     // syntax error
+    CA_TOK,     // single-character token (token value == character)
+    CA_SPC,     // whitespace
+    CA_IDN,     // identifier or keyword
+    CA_NUM,     // decimal number
+    CA_HEX,     // $: hexadecimal number
+    CA_BIN,     // %: binary number
+    CA_OCT,     // @: octal number
+    CA_QUO,     // ": string literal
+    CA_REM,     // ': remark
+    CA_STR,     // *, **
+    CA_PLS,     // +, ++
+    CA_MIN,     // -, --
+    CA_LT,      // <, <=, <<
+    CA_GT       // >, >=, >>
+};
+
+static const uint8_t charAction[256] = {
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SPC, CA_SYN, CA_SPC, CA_SYN, CA_SYN, CA_SPC, CA_SYN, CA_SYN,   // 00
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN,   // 10
+    CA_SPC, CA_TOK, CA_QUO, CA_SYN, CA_HEX, CA_BIN, CA_SYN, CA_REM, CA_TOK, CA_TOK, CA_STR, CA_PLS, CA_TOK, CA_MIN, CA_NUM, CA_TOK,   // 20
+    CA_NUM, CA_NUM, CA_NUM, CA_NUM, CA_NUM, CA_NUM, CA_NUM, CA_NUM, CA_NUM, CA_NUM, CA_TOK, CA_TOK,  CA_LT, CA_TOK,  CA_GT, CA_TOK,   // 30
+    CA_OCT, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN,   // 40
+    CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_TOK, CA_SYN, CA_TOK, CA_TOK, CA_SYN,   // 50
+    CA_SYN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN,   // 60
+    CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_IDN, CA_TOK, CA_TOK, CA_TOK, CA_SYN, CA_SYN,   // 70
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN,   // 80
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN,   // 90
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN,   // A0
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN,   // B0
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN,   // C0
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN,   // D0
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN,   // E0
+    CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN, CA_SYN    // F0
+};
+
+// digit values for bases up to 36 (NOD = not a digit)
+#define NOD             UINT8_C(0XFF)
+
+static const uint8_t digitValue[256] = {
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // 00
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // 10
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // 20
+      0,   1,   2,   3,   4,   5,   6,   7,   8,   9, NOD, NOD, NOD, NOD, NOD, NOD,   // 30
+    NOD,  10,  11,  12,  13,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,   // 40
+     25,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35, NOD, NOD, NOD, NOD, NOD,   // 50
+    NOD,  10,  11,  12,  13,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,   // 60
+     25,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35, NOD, NOD, NOD, NOD, NOD,   // 70
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // 80
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // 90
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // A0
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // B0
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // C0
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // D0
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD,   // E0
+    NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD, NOD    // F0
+};
+
+#undef NOD
+
+// word-at-a-time scanning of identifiers (little-endian GCC targets)
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define TOK_SWAR        1
+#endif
+
+#ifdef TOK_SWAR
+
+#define SWAR_ONES       UINT64_C(0X0101010101010101)
+#define SWAR_HIGHS      UINT64_C(0X8080808080808080)
+
+// sets the high bit of every byte in x that lies strictly between m and n
+// (0 <= m <= 127, 0 <= n <= 128), cf. "Bit Twiddling Hacks", hasbetween()
+static inline uint64_t swarBetween( uint64_t x, unsigned m, unsigned n ) {
+    uint64_t x7 = x & ( SWAR_ONES * 127U );
+    return ( ( SWAR_ONES * ( 127U + n ) - x7 ) & ~x & 
+        ( x7 + SWAR_ONES * ( 127U - m ) ) ) & SWAR_HIGHS;
+}
+
+#endif
+
+// vectorized scanning of string literals, remarks and blank runs
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TOK_AVX2        1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TOK_SSE2        1
+#endif
+
+// returns the position of the first '"' in [p,end), or end
+static inline const uint8_t* findQuote( const uint8_t* p, 
+    const uint8_t* end ) {
+#if defined(TOK_AVX2)
+    const __m256i quote = _mm256_set1_epi8( 0X22 );
+    while ( end - p >= 32 ) {
+        __m256i  x    = _mm256_loadu_si256( (const __m256i*) p );
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8( 
+            _mm256_cmpeq_epi8( x, quote ) );
+        if ( mask ) return p + __builtin_ctz( mask );
+        p += 32;
+    }
+#elif defined(TOK_SSE2)
+    const __m128i quote = _mm_set1_epi8( 0X22 );
+    while ( end - p >= 16 ) {
+        __m128i  x    = _mm_loadu_si128( (const __m128i*) p );
+        uint32_t mask = (uint32_t) _mm_movemask_epi8( 
+            _mm_cmpeq_epi8( x, quote ) );
+        if ( mask ) return p + __builtin_ctz( mask );
+        p += 16;
+    }
+#endif
+    while ( p < end && *p != UINT8_C(0X22) ) ++p;
+    return p;
+}
+
+// returns the position of the first non-blank in [p,end), or end
+static inline const uint8_t* skipBlanks( const uint8_t* p, 
+    const uint8_t* end ) {
+#if defined(TOK_AVX2)
+    const __m256i sp = _mm256_set1_epi8( 0X20 ), bs = _mm256_set1_epi8( 0X08 ),
+                  cr = _mm256_set1_epi8( 0X0D ), lf = _mm256_set1_epi8( 0X0A );
+    while ( end - p >= 32 ) {
+        __m256i  x     = _mm256_loadu_si256( (const __m256i*) p );
+        __m256i  blank = _mm256_or_si256( 
+            _mm256_or_si256( _mm256_cmpeq_epi8( x, sp ), 
+                _mm256_cmpeq_epi8( x, bs ) ),
+            _mm256_or_si256( _mm256_cmpeq_epi8( x, cr ), 
+                _mm256_cmpeq_epi8( x, lf ) ) );
+        uint32_t mask  = ~(uint32_t) _mm256_movemask_epi8( blank );
+        if ( mask ) return p + __builtin_ctz( mask );
+        p += 32;
+    }
+#elif defined(TOK_SSE2)
+    const __m128i sp = _mm_set1_epi8( 0X20 ), bs = _mm_set1_epi8( 0X08 ),
+                  cr = _mm_set1_epi8( 0X0D ), lf = _mm_set1_epi8( 0X0A );
+    while ( end - p >= 16 ) {
+        __m128i  x     = _mm_loadu_si128( (const __m128i*) p );
+        __m128i  blank = _mm_or_si128( 
+            _mm_or_si128( _mm_cmpeq_epi8( x, sp ), _mm_cmpeq_epi8( x, bs ) ),
+            _mm_or_si128( _mm_cmpeq_epi8( x, cr ), _mm_cmpeq_epi8( x, lf ) ) );
+        uint32_t mask  = ~(uint32_t) _mm_movemask_epi8( blank ) & 0XFFFFU;
+        if ( mask ) return p + __builtin_ctz( mask );
+        p += 16;
+    }
+#endif
+    while ( p < end && ( charClass[*p] & CC_SPACE ) ) ++p;
+    return p;
+}
 
 Tokenizer::Tokenizer( const uint8_t* source_, size_t sourceLen_ ) 
     : source(source_), pos(source_), sourceEnd(source_+sourceLen_),
-      sourceLen(sourceLen_), outBuf( TOKBUFSZ ) {}
+      sourceLen(sourceLen_), outBuf( TOKBUFSZ ), out(&outBuf) {}
 
 Tokenizer::~Tokenizer() {
     source = pos = 0; sourceLen = 0;
 }
 
-void Tokenizer::readIdent( uint8_t b ) {
+void Tokenizer::reset( const uint8_t* source_, size_t sourceLen_ ) {
+    source    = pos = source_;
+    sourceEnd = source_ + sourceLen_;
+    sourceLen = sourceLen_;
+    outBuf.setWritePos( 0 );
+}
+
+void Tokenizer::readIdent() {
+    const uint8_t* p = pos;
     int len = 0;
-    do {
-        if ( b >= UINT8_C(0X61) && b <= UINT8_C(0X7A) ) b -= UINT8_C(0X20);
+#ifdef TOK_SWAR
+    while ( sourceEnd - p >= 8 ) {
+        uint64_t x; memcpy( &x, p, 8U );
+        uint64_t alnum = swarBetween( x, 0X2FU, 0X3AU ) |     // 0..9
+                         swarBetween( x, 0X40U, 0X5BU ) |     // A..Z
+                         swarBetween( x, 0X60U, 0X7BU );      // a..z
+        // fold a..z to A..Z: 0X80 >> 2 == 0X20
+        x -= swarBetween( x, 0X60U, 0X7BU ) >> 2U;
+        int n = 8;
+        if ( alnum != SWAR_HIGHS ) {
+            n = __builtin_ctzll( ~alnum & SWAR_HIGHS ) >> 3;
+        }
+        int room = ( MAXIDENT-2 ) - len;
+        if ( room > 0 ) {
+            int m = n < room ? n : room;
+            memcpy( &ident[len], &x, m );
+            len += m;
+        }
+        p += n;
+        if ( n < 8 ) goto DONE;
+    }
+#endif
+    while ( p < sourceEnd && ( charClass[*p] & CC_ALNUM ) ) {
+        uint8_t b = *p++;
+        if ( charClass[b] & CC_LOWER ) b -= UINT8_C(0X20);
         if ( len < MAXIDENT-2 ) ident[len++] = b;
-        if ( ++pos >= sourceEnd ) break;
-        b = *pos;
-    } while ( ( b >= UINT8_C(0X41) && b <= UINT8_C(0X5A) ) ||   // A..Z
-        ( b >= UINT8_C(0X61) && b <= UINT8_C(0X7A) ) ||         // a..z
-        ( b >= UINT8_C(0X30) && b <= UINT8_C(0X39) ) );         // 0..9
-    if ( b == UINT8_C(0X24) || b == UINT8_C(0X25) ) do {    // $, %
-        ident[len++] = b;
-        if ( ++pos >= sourceEnd ) break;
-        b = *pos;
-    } while (0);
-    if ( b == UINT8_C(0X28) ) { // (
-        ident[len++] = b;
-        ++pos;
+    }
+#ifdef TOK_SWAR
+DONE:
+#endif
+    pos = p;
+    if ( pos < sourceEnd && ( *pos == UINT8_C(0X24) ||      // $
+        *pos == UINT8_C(0X25) ) ) {                         // %
+        ident[len++] = *pos++;
+    }
+    if ( pos < sourceEnd && *pos == UINT8_C(0X28) ) {       // (
+        ident[len++] = *pos++;
     }
     idLen = len;
 }
 
 int Tokenizer::digitVal( uint8_t b, int base ) {
-    uint8_t v;
-    if ( b >= UINT8_C(0X30) && b <= UINT8_C(0X39) ) {
-        v = b - UINT8_C(0X30);
-    } else if ( b >= UINT8_C(0X41) && b <= UINT8_C(0X5A) ) {
-        v = ( b - UINT8_C(0X41) ) + UINT8_C(10);
-    } else if ( b >= UINT8_C(0X61) && b <= UINT8_C(0X7A) ) {
-        v = ( b - UINT8_C(0X61) ) + UINT8_C(10);
-    } else {
-        return -1;
-    }
-    if ( (int) v >= base ) return -1;
-    return (int) v;
+    int v = digitValue[b];
+    return v < base ? v : -1;
 }
 
 bool Tokenizer::isDigit( uint8_t b, int base ) {
-    return digitVal( b, base ) >= 0;
+    return digitValue[b] < base;
 }
 
 int Tokenizer::bitsPerDigit( int base ) {
@@ -84,232 +291,270 @@ int Tokenizer::bitsPerDigit( int base ) {
     return nBits;
 }
 
-char* Tokenizer::digitToBitGroup( char* buf, char* bufEnd, uint8_t b, 
-    int base ) {
-    int v = digitVal( b, base );
-    if ( v < 0 ) return 0;
-    int digitBits = bitsPerDigit( base );
-    char* end = &buf[digitBits];
-    if ( end > bufEnd ) return 0;
-    while ( digitBits > 0 ) {
-        int b = v & 1; v >>= 1;
-        buf[ --digitBits ] = '0' + b;
-    }
-    return end;
-}
-
-char* Tokenizer::digitsToBitGroup( char* buf, char* bufEnd, const char* dig,
-     int ndig, int base ) {
-    while ( ndig ) {
-        buf = digitToBitGroup( buf, bufEnd, *dig, base );
-        if ( buf == 0 ) return 0;
-        --ndig; ++dig;
+// exactly representable powers of ten (Clinger's fast path)
+static const double exactPow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAXEXACTPOW10   22
+#define MAXEXACTMANT    UINT64_C(0X20000000000000)  // 2^53
+#define MAXDECMANT      19      // decimal digits that fit into uint64_t
+#define MAXEXPVAL       1000000000L
+
+// Decimal significand (up to MAXDECMANT digits) times a power of ten.
+// Returns false if the value cannot be converted exactly.
+static bool decToDouble( uint64_t mant, long exp10, double& rVal ) {
+    if ( mant == 0 ) { rVal = 0; return true; }
+    if ( mant > MAXEXACTMANT ) return false;
+    if ( exp10 < 0 ) {
+        if ( exp10 < -MAXEXACTPOW10 ) return false;
+        rVal = (double) mant / exactPow10[-exp10];
+        return true;
     }
-    return buf;
+    if ( exp10 > MAXEXACTPOW10 ) {
+        // 123E25 = 123000E22: move excess zeros into the significand
+        for ( ; exp10 > MAXEXACTPOW10; --exp10 ) {
+            mant *= 10U;
+            if ( mant > MAXEXACTMANT ) return false;
+        }
+    }
+    rVal = (double) mant * exactPow10[exp10];
+    return true;
 }
 
-char* Tokenizer::digitsToHex( char* buf, int nbits ) {
-    char* out = buf;
-    while ( nbits ) {
-        uint8_t b3 = buf[0] - '0';
-        uint8_t b2 = buf[1] - '0';
-        uint8_t b1 = buf[2] - '0';
-        uint8_t b0 = buf[3] - '0';
-        b3 <<= 3; b2 <<= 2; b1 <<= 1;
-        uint8_t b  = b3 | b2 | b1 | b0;
-        *out++ = "0123456789ABCDEF" [ b ];
-        buf += 4; nbits -= 4;
-    }
-    return out;
+// Binary significand (with sticky bit for lost nonzero bits) times a 
+// power of two, rounded to nearest even. Returns false on overflow, 
+// and on inexact underflow (the cases glibc's strtod() reports with 
+// ERANGE).
+static bool binToDouble( uint64_t mant, bool sticky, long exp2, 
+    double& rVal ) {
+    if ( mant == 0 ) { rVal = 0; return true; }
+    while ( !( mant & UINT64_C(0X8000000000000000) ) ) { mant <<= 1U; --exp2; }
+    long topExp = exp2 + 63L;   // weight of the top bit
+    if ( topExp > 1023L ) return false;
+    int  drop = 11;             // bits below the 53-bit significand
+    bool tiny = false;
+    if ( topExp < -1022L ) {    // subnormal: fewer significand bits
+        if ( topExp < -1022L - 52L ) return false;
+        drop += (int)( -1022L - topExp );
+        tiny  = true;
+    }
+    uint64_t kept = mant >> drop;
+    uint64_t rest = mant & ( ( UINT64_C(1) << drop ) - 1U );
+    uint64_t half = UINT64_C(1) << ( drop - 1 );
+    if ( rest > half || ( rest == half && ( sticky || ( kept & 1U ) ) ) ) {
+        ++kept;
+    }
+    // subnormal (or zero) after rounding, and not exact
+    if ( tiny && ( rest || sticky ) && kept < UINT64_C(0X10000000000000) ) {
+        return false;
+    }
+    rVal = ldexp( (double) kept, (int)( exp2 + drop ) );
+    return !isinf( rVal );
 }
 
-uint16_t Tokenizer::readNum( const char* buf, int len, int base, 
-    bool haveDot, bool haveExp ) {
-    if ( !haveDot && !haveExp ) {
-        char* endPtr = 0; errno = 0;
-        #if ULONG_MAX == 18446744073709551615UL
-        uint64_t v = strtoul( buf, &endPtr, base );
-        #else
-        uint64_t v = strtoull( buf, &endPtr, base );
-        #endif
-        if ( errno != 0 ) return T_NUMBAD;
-        if ( (const char*) endPtr != buf + len ) return T_NUMBAD;
-        if ( (int64_t) v < 0 ) return T_NUMBAD;
-        intVal  = v;
-        isInt   = true;
-        numBase = base;
-        return T_NUMLIT;
-    } else if ( base == 10 ) {  // base 10 floating-point
-        realVal = atof( buf );
-        isInt   = false;
-        numBase = 10;
-        return T_NUMLIT;
-    }
-    // floating-point conversion for non base 10 numbers
-    // bases 2, 8 and 16 can easily be converted into bit patterns
-    int preDotDigits = 0, postDotDigits = 0, dotPos = -1, expPos = -1;
-    if ( haveDot ) {
-        const char* p = buf;
-        while ( isDigit( *p, base ) ) ++p;
-        // p is on dot now
-        preDotDigits = (int)( p - buf );
-        if ( *p != '.' ) return T_INTERR;
-        dotPos = preDotDigits;
-        ++p; const char* p0 = p;
-        while ( isDigit( *p, base ) ) ++p;
-        // p is on either exponent specifier or '\0' now
-        postDotDigits = (int)( p - p0 );
-        if ( haveExp ) expPos = (int)( p - buf );
-    } else {
-        const char* p = buf;
-        while ( isDigit( *p, base ) ) ++p;
-        // p is on either exponent specifier or '\0' now
-        preDotDigits = (int)( p - buf );
-        if ( haveExp ) expPos = preDotDigits;
-    }
-    char buf2[NUMBUFSZ*4+1]; int pos = 0;
-    char* buf2End = &buf2[NUMBUFSZ*4];
-    buf2[pos++] = '0';
-    buf2[pos  ] = 'X';
-    // transcribe digits into hexadecimal form, beginning with digits before dot
-    char* endPtr = 0; errno = 0;
-    #if ULONG_MAX == 18446744073709551615UL
-    uint64_t v = strtoul( buf, &endPtr, base );
-    #else
-    uint64_t v = strtoull( buf, &endPtr, base );
-    #endif
-    if ( errno != 0 ) return T_NUMBAD;
-    if ( (const char*) endPtr != buf + preDotDigits ) return T_NUMBAD;
-    if ( (int64_t) v < 0 ) return T_NUMBAD;
-    #if ULONG_MAX == 18446744073709551615UL
-    snprintf( &buf2[2], NUMBUFSZ*4-2, "%lX", v );
-    #else
-    snprintf( &buf2[2], NUMBUFSZ*4-2, "%LX", v );
-    #endif
-    pos = (int) strlen(buf2);
-    if ( haveDot ) buf2[pos++] = '.';
-    if ( postDotDigits ) {
-        char* start = &buf2[pos];
-        char* end = digitsToBitGroup( start, buf2End, &buf[dotPos+1],
-            postDotDigits, base );
-        if ( end == 0 ) return T_INTERR;
-        int nbits = (int)( end - start );
-        // pad to 4 digit alignment
-        while ( nbits & 3 ) {
-            *end++ = '0'; ++nbits;
+// Adds a digit to the leading significant digits of a literal. mant
+// holds up to MAXDECMANT decimal digits (bpd < 0) or 64 bits, scale
+// counts the digits (or bits) not represented by it, and sticky records
+// whether any of the digits that did not fit were nonzero.
+static inline void addDigit( int d, int bpd, bool frac, uint64_t& mant,
+    int& nMant, bool& sticky, long& scale ) {
+    if ( bpd < 0 ) {
+        if ( nMant < MAXDECMANT ) {
+            mant = mant * 10U + d; if ( mant ) ++nMant;
+            if ( frac ) --scale;
+        } else {
+            sticky |= d != 0; if ( !frac ) ++scale;
         }
-        *end = '\0';
-        // convert binary digits to hex
-        end = digitsToHex( start, nbits );
-        pos = end - &buf2[0];
-    }
-    if ( haveExp ) {
-        buf2[pos++] = 'P';
-        // library expects exponent to be in decimal form -- comply
-        errno = 0;
-        long ex = strtol( &buf[expPos+1], 0, base );
-        if ( errno != 0 ) return T_NUMBAD;
-        // need to correct exponent, since base 2 is expected
-        int mult = bitsPerDigit( base ); ex *= mult;
-        snprintf( &buf2[pos], NUMBUFSZ*4-pos, "%ld", ex );
-        pos = strlen(buf2);
-    }
-    buf2[pos] = '\0';
-    errno = 0;
-    double v2 = strtod( buf2, 0 );
-    if ( errno != 0 ) return T_NUMBAD;
-    realVal = v2;
-    isInt   = false;
-    numBase = base;
-    return T_NUMLIT;
+    } else if ( mant >> ( 64 - bpd ) ) {
+        sticky |= d != 0; if ( !frac ) scale += bpd;
+    } else {
+        mant = ( mant << bpd ) | d; if ( frac ) scale -= bpd;
+    }
 }
 
-uint16_t Tokenizer::readNum( uint8_t b, int base ) {
-    char numBuf[NUMBUFSZ+1];
-    int nbPos = 0; bool haveDot = false;
+uint16_t Tokenizer::scanNum( const uint8_t*& p, const uint8_t* end, 
+    int base, int64_t& rIntVal, double& rRealVal, bool& rIsInt ) {
+
+    // The literal is measured in the form it was once copied to a buffer
+    // of NUMBUFSZ characters: leading '0' for '.5', trailing '0' for '5.',
+    // exponent letter and minus sign, but no plus sign.
+    int nStored = 0;
+#define STORE_CHAR() \
+    do { if ( nStored >= NUMBUFSZ ) return T_NUMLNG; ++nStored; } while (0)
+
+    const uint8_t* start   = p;
+    int            bpd     = bitsPerDigit( base );  // -1 for base 10
+    uint64_t       intPart = 0;         // digits before dot (exact)
+    bool           intOvf  = false;     // intPart exceeds INT64_MAX
+    uint64_t       mant    = 0;         // leading significant digits
+    int            nMant   = 0;         // decimal digits in mant
+    bool           sticky  = false;     // nonzero digits beyond mant
+    long           scale   = 0;         // exponent correction for mant
+    bool           haveDot = false, haveExp = false;
+
+    uint8_t b = *p;
     if ( b == UINT8_C(0X2E) ) { // .
-        numBuf[nbPos++] = UINT8_C(0X30);    // 0
+        STORE_CHAR();           // implied 0
         haveDot = true;
     }
     do {    // read digits (before/after dot)
-        if ( nbPos >= NUMBUFSZ ) return T_NUMLNG;
-        numBuf[nbPos++] = b;
-        if ( ++pos >= sourceEnd ) break;
-        b = *pos;
+        STORE_CHAR();
+        if ( b != UINT8_C(0X2E) ) {
+            int d = digitValue[b];
+            if ( !haveDot ) {
+                if ( intPart > ( (uint64_t) INT64_MAX - d ) / base ) {
+                    intOvf = true;
+                } else {
+                    intPart = intPart * base + d;
+                }
+            }
+            addDigit( d, bpd, haveDot, mant, nMant, sticky, scale );
+        }
+        if ( ++p >= end ) break;
+        b = *p;
     } while ( isDigit( b, base ) );
-    if ( !haveDot && b == UINT8_C(0X2E) ) do {  // .
-        // store dot
+    if ( !haveDot && p < end && b == UINT8_C(0X2E) ) {  // .
         haveDot = true;
-        if ( nbPos >= NUMBUFSZ ) return T_NUMLNG;
-        numBuf[nbPos++] = b;
-        // if EOL occurs right after dot
-        if ( ++pos >= sourceEnd ) {
-            // attempt to store at least one zero
-            if ( nbPos >= NUMBUFSZ ) return T_NUMLNG;
-            numBuf[nbPos++] = UINT8_C(0X30);    // 0
-            break;
-        }
-        // otherwise, check if there's a digit after the dot
-        b = *pos;
-        if ( isDigit( b, base ) ) {
-            // yes, continue to read and store digits
+        STORE_CHAR();
+        // if EOL occurs right after the dot, or no digit follows it,
+        // count the implied zero; otherwise, read the digits
+        if ( ++p >= end || !isDigit( b = *p, base ) ) {
+            STORE_CHAR();
+        } else {
             do {
-                if ( nbPos >= NUMBUFSZ ) return T_NUMLNG;
-                numBuf[nbPos++] = b;
-                if ( ++pos >= sourceEnd ) break;
-                b = *pos;
+                STORE_CHAR();
+                addDigit( digitValue[b], bpd, true, mant, nMant, sticky,
+                    scale );
+                if ( ++p >= end ) break;
+                b = *p;
             } while ( isDigit( b, base ) );
-        } else {
-            // no, store at least a zero
-            if ( nbPos >= NUMBUFSZ ) return T_NUMLNG;
-            numBuf[nbPos++] = UINT8_C(0X30);    // 0
-        }        
-    } while(0);
+        }
+    }
     // check for exponent (P for bases > 10, E otherwise)
-    bool haveExp = false;
-    if ( ( base > 10 && ( b == UINT8_C(0X50) || // P p
+    long expVal = 0; bool expOvf = false;
+    if ( p < end && ( ( base > 10 && ( b == UINT8_C(0X50) ||  // P p
         b == UINT8_C(0X70) ) ) || ( b == UINT8_C(0X45) ||   // E e
-        b == UINT8_C(0X65) ) ) {
-        if ( nbPos >= NUMBUFSZ ) return T_NUMLNG;
-        numBuf[nbPos++] = b;
-        if ( ++pos >= sourceEnd ) return T_NUMBAD;
-        b = *pos;
+        b == UINT8_C(0X65) ) ) ) {
+        STORE_CHAR();
+        if ( ++p >= end ) return T_NUMBAD;
+        b = *p;
+        bool negExp = false;
         // check for '+' or '-'
         if ( b == UINT8_C(0X2B) ) {
             // '+': ignore
-            if ( ++pos >= sourceEnd ) return T_NUMBAD;
-            b = *pos;
+            if ( ++p >= end ) return T_NUMBAD;
+            b = *p;
         } else if ( b == UINT8_C(0X2D) ) {
-            // '-': store
-            if ( nbPos >= NUMBUFSZ ) return T_NUMLNG;
-            numBuf[nbPos++] = b;
-            if ( ++pos >= sourceEnd ) return T_NUMBAD;
-            b = *pos;
+            // '-': count
+            STORE_CHAR();
+            negExp = true;
+            if ( ++p >= end ) return T_NUMBAD;
+            b = *p;
         }
         // check for digits
         if ( !isDigit( b, base ) ) return T_NUMBAD;
         do {
-            if ( nbPos >= NUMBUFSZ ) return T_NUMLNG;
-            numBuf[nbPos++] = b;
-            if ( ++pos >= sourceEnd ) break;
-            b = *pos;
+            STORE_CHAR();
+            long d = digitValue[b];
+            if ( expVal > ( LONG_MAX - d ) / base ) expOvf = true;
+            else expVal = expVal * base + d;
+            if ( ++p >= end ) break;
+            b = *p;
         } while ( isDigit( b, base ) );
+        if ( negExp ) expVal = -expVal;
         haveExp = true;        
     }
-    numBuf[nbPos] = '\0';
-    return readNum( numBuf, nbPos, base, haveDot, haveExp );
+#undef STORE_CHAR
+
+    if ( !haveDot && !haveExp ) {
+        if ( intOvf ) return T_NUMBAD;
+        rIntVal = (int64_t) intPart;
+        rIsInt  = true;
+        return T_NUMLIT;
+    }
+
+    rIsInt = false;
+    if ( bpd < 0 ) {    // base 10 floating-point
+        if ( !sticky && !expOvf && expVal > -MAXEXPVAL && 
+            expVal < MAXEXPVAL && decToDouble( mant, scale + expVal, 
+            rRealVal ) ) {
+            return T_NUMLIT;
+        }
+        // not exactly representable: let the C library round it
+        char buf[NUMBUFSZ+2];
+        size_t len = p - start;
+        if ( len >= sizeof(buf) ) return T_INTERR;
+        memcpy( buf, start, len ); buf[len] = '\0';
+        rRealVal = strtod( buf, 0 );
+        return T_NUMLIT;
+    }
+
+    // bases 2, 8 and 16: assemble the bits directly
+    if ( intOvf || expOvf ) return T_NUMBAD;
+    if ( expVal > MAXEXPVAL || expVal < -MAXEXPVAL ) {
+        // out of range unless zero
+        if ( mant != 0 ) return T_NUMBAD;
+        rRealVal = 0;
+        return T_NUMLIT;
+    }
+    if ( !binToDouble( mant, sticky, scale + expVal * bpd, rRealVal ) ) {
+        return T_NUMBAD;
+    }
+    return T_NUMLIT;
+}
+
+uint16_t Tokenizer::strToNum( const uint8_t* p, size_t len, 
+    int64_t& rIntVal, double& rRealVal, bool& rIsInt ) {
+    const uint8_t* end   = p + len;
+    bool           minus = false;
+    int            base  = 10;
+    while ( p < end && ( charClass[*p] & CC_SPACE ) ) ++p;
+    if ( p < end && ( *p == UINT8_C(0X2D) || *p == UINT8_C(0X2B) ) ) {  // - +
+        minus = *p++ == UINT8_C(0X2D);
+        while ( p < end && ( charClass[*p] & CC_SPACE ) ) ++p;
+    }
+    if ( p >= end ) return T_EOL;
+    switch ( *p ) {
+        case UINT8_C(0X24): base = 16; ++p; break;     // $
+        case UINT8_C(0X25): base =  2; ++p; break;     // %
+        case UINT8_C(0X40): base =  8; ++p; break;     // @
+        case UINT8_C(0X26):                            // &H &O &B
+            if ( end - p < 2 ) return T_SYNERR;
+            switch ( p[1] | UINT8_C(0X20) ) {
+                case UINT8_C(0X68): base = 16; break;
+                case UINT8_C(0X6F): base =  8; break;
+                case UINT8_C(0X62): base =  2; break;
+                default: return T_SYNERR;
+            }
+            p += 2;
+            break;
+        default: break;
+    }
+    if ( p >= end ) return T_NUMBAD;
+    if ( !isDigit( *p, base ) && *p != UINT8_C(0X2E) ) {
+        return base == 10 ? T_SYNERR : T_NUMBAD;
+    }
+    uint16_t tok = scanNum( p, end, base, rIntVal, rRealVal, rIsInt );
+    if ( tok == T_NUMLIT && minus ) {
+        if ( rIsInt ) rIntVal = -rIntVal; else rRealVal = -rRealVal;
+    }
+    return tok;
 }
 
 uint16_t Tokenizer::readNum( int base ) {
     if ( pos >= sourceEnd ) return T_NUMBAD;
     uint8_t b = *pos;
     if ( !isDigit( b, base ) && b != UINT8_C(0X2E) ) return T_NUMBAD;
-    return readNum( b, base );
+    uint16_t tok = scanNum( pos, sourceEnd, base, intVal, realVal, isInt );
+    if ( tok == T_NUMLIT ) numBase = base;
+    return tok;
 }
 
 uint16_t Tokenizer::nextTok() {
 
-    uint8_t b; uint16_t t; bool isRem;
+    uint8_t b; uint16_t t;
 
 REDO:
 
@@ -317,116 +562,92 @@ REDO:
 
     b = *pos;
 
-    switch ( b ) {
-        case UINT8_C(0X21): ++pos; return T_PLING;      // !
-        case UINT8_C(0X24): ++pos; return readNum( 16 );    // $
-        case UINT8_C(0X25): ++pos; return readNum( 2 ); // %
-        case UINT8_C(0X28): ++pos; return T_LPAREN;     // (
-        case UINT8_C(0X29): ++pos; return T_RPAREN;     // )
-        case UINT8_C(0X2A): ++pos; 
+    switch ( charAction[b] ) {
+        case CA_TOK: ++pos; return b;   // ! ( ) , / : ; = ? [ ] ^ { | }
+        case CA_HEX: ++pos; return readNum( 16 );   // $
+        case CA_BIN: ++pos; return readNum( 2 );    // %
+        case CA_OCT: ++pos; return readNum( 8 );    // @
+        case CA_STR: ++pos; 
             if ( pos >= sourceEnd ) return T_TIMES;
             b = *pos;
             if ( b == UINT8_C(0X2A) ) { ++pos; return T_POW; }  // **, ^
             return T_TIMES;                             // *
-        case UINT8_C(0X2B): ++pos; 
+        case CA_PLS: ++pos; 
             if ( pos >= sourceEnd ) return T_PLUS;
             b = *pos;
             if ( b == UINT8_C(0X2B) ) { ++pos; return KW_INC; } // ++, INC
             return T_PLUS;                              // +
-        case UINT8_C(0X2C): ++pos; return T_COMMA;      // ,
-        case UINT8_C(0X2D): ++pos; 
+        case CA_MIN: ++pos; 
             if ( pos >= sourceEnd ) return T_MINUS;
             b = *pos;
             if ( b == UINT8_C(0X2D) ) { ++pos; return KW_DEC; } // --, DEC
             return T_MINUS;                             // -
-        case UINT8_C(0X2F): ++pos; return T_DIV;        // /
-        case UINT8_C(0X3A): ++pos; return T_COLON;      // :
-        case UINT8_C(0X3B): ++pos; return T_SEMIC;      // ;
-        case UINT8_C(0X3C): ++pos;
+        case CA_LT: ++pos;
             if ( pos >= sourceEnd ) return T_LT;
             b = *pos;
             if ( b == UINT8_C(0X3D) ) { ++pos; return T_LE; } // <=
             if ( b == UINT8_C(0X3C) ) { ++pos; return KW_SHL; } // <<, SHL
             return T_LT;                                // <
-        case UINT8_C(0X3D): ++pos;  return T_EQ;        // =
-        case UINT8_C(0X3E): ++pos;
+        case CA_GT: ++pos;
             if ( pos >= sourceEnd ) return T_GT;
             b = *pos;
             if ( b == UINT8_C(0X3D) ) { ++pos; return T_GE; } // >=
             if ( b == UINT8_C(0X3E) ) { ++pos; return KW_SHR; } // >>, SHR
             return T_GT;                                // >
-        case UINT8_C(0X3F): ++pos; return T_PRINT;      // ?, PRINT
-        case UINT8_C(0X40): ++pos; return readNum( 8 ); // @
-        case UINT8_C(0X5B): ++pos; return T_LBRACK;     // [
-        case UINT8_C(0X5D): ++pos; return T_RBRACK;     // ]
-        case UINT8_C(0X5E): ++pos; return T_POW;        // ^, **
-        case UINT8_C(0X7B): ++pos; return T_LBRACE;     // {
-        case UINT8_C(0X7C): ++pos; return T_LEXT;       // |
-        case UINT8_C(0X7D): ++pos; return T_RBRACE;     // }
-        default: break;
-    }
-
-    if ( ( b >= UINT8_C(0X41) && b <= UINT8_C(0X5A) ) ||    // A..Z
-        ( b >= UINT8_C(0X61) && b <= UINT8_C(0X7A) ) ) {    // a..z
-        readIdent( b );
-        t = Keywords::getInstance().lookup( ident, idLen );
-        if ( t != KW_NOTFOUND ) {
+        case CA_SPC:    // SP BS CR LF
+            // CR, LF should not normally occur within a text line
+            if ( ++pos < sourceEnd && ( charClass[*pos] & CC_SPACE ) ) {
+                pos = skipBlanks( pos, sourceEnd );
+            }
+            goto REDO;
+        case CA_IDN:
+            readIdent();
+            t = Keywords::getInstance().lookup( ident, idLen );
+            if ( t == KW_NOTFOUND ) return T_IDENT;
             if ( t != T_REM ) return t;
-            b = UINT8_C(0X27); // '
-            isRem = true;
-        } else {
-            return T_IDENT;
+            goto REM;
+        case CA_QUO: {  // "
+            // the literal may hold up to MAXSTRLIT-1 characters
+            const uint8_t* start = ++pos;
+            const uint8_t* limit = sourceEnd - start > MAXSTRLIT ? 
+                start + MAXSTRLIT : sourceEnd;
+            const uint8_t* quote = findQuote( start, limit );
+            if ( quote < limit && quote - start < MAXSTRLIT ) {
+                slLen = (int)( quote - start );
+                memcpy( strlit, start, slLen );
+                pos = quote + 1;
+                return T_STRLIT;
+            }
+            if ( sourceEnd - start <= MAXSTRLIT ) {
+                pos = sourceEnd;
+                return T_STRTRM;
+            }
+            pos = start + MAXSTRLIT;
+            return T_STRLNG;
         }
-    } else {
-        isRem = false;
-    }
-
-    if ( b == UINT8_C(0X20) || b == UINT8_C(0X08) || 
-         b == UINT8_C(0X0D) || b == UINT8_C(0X0A) ) {   // SP HT CR LF
-        // CR, LF should not normally occur within a text line
-        do {
-            if ( ++pos >= sourceEnd ) break;
-            b = *pos;
-        } while ( b == UINT8_C(0X20) || b == UINT8_C(0X08) || 
-         b == UINT8_C(0X0D) || b == UINT8_C(0X0A) );
-        goto REDO;
-    }
-
-    if ( b == UINT8_C(0X22) ) { // "
-        slLen = 0;
-        do {
-            if ( ++pos >= sourceEnd ) return T_STRTRM;
-            if ( slLen >= MAXSTRLIT ) return T_STRLNG;
-            b = *pos;
-            if ( b == UINT8_C(0X22) ) { ++pos; break; }
-            strlit[slLen++] = b;
-        } while (1);
-        return T_STRLIT;
-    }
-
-    if ( b == UINT8_C(0X27) ) { // ', REM
-        if ( !isRem ) ++pos;
-        if ( pos < sourceEnd && *pos == UINT8_C(0X20) ) ++pos;
-        slLen = 0;
-        do {
-            if ( pos >= sourceEnd ) break;
-            b = *pos++;
-            if ( slLen < MAXSTRLIT ) strlit[slLen++] = b;
-        } while (1);
-        return T_REM;
-    }
-
-    if ( ( b >= UINT8_C(0X30) && b <= UINT8_C(0X39) ) || // 0..9
-        b == UINT8_C(0X2E) ) { // .
-        return readNum( b, 10 );
+        case CA_REM:    // ', REM
+            ++pos;
+REM:        if ( pos < sourceEnd && *pos == UINT8_C(0X20) ) ++pos;
+            // the remark extends to the end of the line; only the first
+            // MAXSTRLIT characters are kept
+            slLen = sourceEnd - pos > MAXSTRLIT ? MAXSTRLIT : 
+                (int)( sourceEnd - pos );
+            memcpy( strlit, pos, slLen );
+            pos = sourceEnd;
+            return T_REM;
+        case CA_NUM:    // 0..9 .
+            return readNum( 10 );
+        default: break;
     }
 
     return T_SYNERR;
 }
 
 bool Tokenizer::storeLineNo() {
-    if ( !outBuf.writeByte( T_LINENO ) ) return false;
-    return outBuf.writeLineNo( (uint32_t) intVal );
+    if ( !out->reserve( 4U ) ) return false;
+    out->putByte( T_LINENO );
+    out->putLineNo( (uint32_t) intVal );
+    return true;
 }
 
 bool Tokenizer::storeInt() {
@@ -452,21 +673,25 @@ bool Tokenizer::storeInt() {
     } else {
         return false;
     }
+    if ( !out->reserve( 10U ) ) return false;
     if ( loNyb == NL_I8 && hiNyb == NH_DEC ) {
         // special encoding for single-byte integer
-        if ( !outBuf.writeByte( T_SBI ) ) return false;
-        return outBuf.writeByte( (int8_t) intVal );
+        out->putByte( T_SBI );
+        out->putByte( (int8_t) intVal );
+        return true;
     }
-    if ( !outBuf.writeByte( T_NUMLIT ) ) return false;
-    if ( !outBuf.writeByte( hiNyb | loNyb ) ) return false;
+    out->putByte( T_NUMLIT );
+    out->putByte( hiNyb | loNyb );
     if ( loNyb == NL_I8 ) {
-        return outBuf.writeByte( (uint8_t) intVal );
+        out->putByte( (uint8_t) intVal );
     } else if ( loNyb == NL_I16 ) {
-        return outBuf.writeWord( (uint16_t) intVal );
+        out->putWord( (uint16_t) intVal );
     } else if ( loNyb == NL_I32 ) {
-        return outBuf.writeDWord( (uint32_t) intVal );
-    } 
-    return outBuf.writeQWord( (uint64_t) intVal );
+        out->putDWord( (uint32_t) intVal );
+    } else {
+        out->putQWord( (uint64_t) intVal );
+    }
+    return true;
 }
 
 bool Tokenizer::storeReal() {
@@ -518,36 +743,39 @@ bool Tokenizer::storeReal() {
     } else {
         return false;
     }
-    if ( !outBuf.writeByte( T_NUMLIT ) ) return false;
-    if ( !outBuf.writeByte( hiNyb | loNyb ) ) return false;
+    if ( !out->reserve( 10U ) ) return false;
+    out->putByte( T_NUMLIT );
+    out->putByte( hiNyb | loNyb );
     if ( cnv ) {
-        return outBuf.writeReal32( (float) realVal );
+        out->putReal32( (float) realVal );
+    } else {
+        out->putReal64( realVal );
     }
-    return outBuf.writeReal64( realVal );
+    return true;
 }
 
 bool Tokenizer::storeLabel() {
-    if ( !outBuf.writeByte( T_LABEL ) ) return false;
-    if ( !outBuf.writeByte( (uint8_t) idLen ) ) return false;
-    return outBuf.writeBlock( ident, idLen );
+    if ( !out->writeByte( T_LABEL ) ) return false;
+    if ( !out->writeByte( (uint8_t) idLen ) ) return false;
+    return out->writeBlock( ident, idLen );
 }
 
 bool Tokenizer::storeIdent() {
-    if ( !outBuf.writeByte( T_IDENT ) ) return false;
-    if ( !outBuf.writeByte( (uint8_t) idLen ) ) return false;
-    return outBuf.writeBlock( ident, idLen );
+    if ( !out->writeByte( T_IDENT ) ) return false;
+    if ( !out->writeByte( (uint8_t) idLen ) ) return false;
+    return out->writeBlock( ident, idLen );
 }
 
 bool Tokenizer::storeStrLit() {
-    if ( !outBuf.writeByte( T_STRLIT ) ) return false;
-    if ( !outBuf.writeByte( (uint8_t) slLen ) ) return false;
-    return outBuf.writeBlock( strlit, slLen );
+    if ( !out->writeByte( T_STRLIT ) ) return false;
+    if ( !out->writeByte( (uint8_t) slLen ) ) return false;
+    return out->writeBlock( strlit, slLen );
 }
 
 bool Tokenizer::storeRem() {
-    if ( !outBuf.writeByte( T_REM ) ) return false;
-    if ( !outBuf.writeByte( (uint8_t) slLen ) ) return false;
-    return outBuf.writeBlock( strlit, slLen );
+    if ( !out->writeByte( T_REM ) ) return false;
+    if ( !out->writeByte( (uint8_t) slLen ) ) return false;
+    return out->writeBlock( strlit, slLen );
 }
 
 bool Tokenizer::identDecorated() const {
@@ -569,6 +797,14 @@ bool Tokenizer::locationToken( uint16_t tok ) {
     return false;
 }
 
+bool Tokenizer::labelRef( bool afterThen ) const {
+    if ( !afterThen ) return true;
+    // after THEN, only a lone identifier: IF A THEN B = 1 assigns
+    const uint8_t* p = pos;
+    while ( p < sourceEnd && ( charClass[*p] & CC_SPACE ) ) ++p;
+    return p >= sourceEnd || *p == UINT8_C(0X3A);
+}
+
 bool Tokenizer::locationExprToken( uint16_t tok ) {
     switch ( tok ) {
         case KW_LIST: case KW_DELETE:
@@ -581,12 +817,16 @@ uint16_t Tokenizer::tokenize() {
 
     bool first = true;
     uint16_t stickyTok = T_EOL;
+    bool lineStart = true;      // at the start, or after the line number
+    bool wantTarget = false;    // a jump target may follow
+    bool wasTarget = false;     // previous token was a jump target
+    bool afterThen = false;     // previous token was THEN
     
     for (;;) {
         uint16_t tok = nextTok();
         if ( tok == T_EOL || tok >= UINT16_C(0XFF00) ) {
             if ( tok == T_EOL ) {
-                if ( !outBuf.writeByte( T_EOL ) ) return T_MEMERR;
+                if ( !out->writeByte( T_EOL ) ) return T_MEMERR;
             }
             return tok;
 
@@ -612,23 +852,23 @@ uint16_t Tokenizer::tokenize() {
         } else if ( tok == T_NUMLIT ) {
             if ( !storeReal() ) return T_MEMERR;
 
-        } else if ( tok == T_IDENT ) {
-            // if followed by colon, might be label
-            if ( pos < sourceEnd && *pos == UINT8_C(0X3A) ) {
-                ++pos;
-                if ( identDecorated() ) return T_SYNERR;
-                if ( !storeLabel() ) return T_MEMERR;
-                tok = T_LABEL;
+        } else if ( tok == T_IDENT && lineStart && pos < sourceEnd && 
+            *pos == UINT8_C(0X3A) ) {
+            // label definition: first on the line, with colon
+            ++pos;
+            if ( identDecorated() ) return T_SYNERR;
+            if ( !storeLabel() ) return T_MEMERR;
+            tok = T_LABEL;
 
-            } else {
-                if ( !storeIdent() ) return T_MEMERR;
-            }
-        } else if ( tok == T_IDENT && stickyTok != T_EOL ) {
-            // identifier after certain keywords is a label
+        } else if ( tok == T_IDENT && wantTarget && labelRef( afterThen ) ) {
+            // identifier as jump target is a label
             if ( identDecorated() ) return T_SYNERR;
             if ( !storeLabel() ) return T_MEMERR;
             tok = T_LABEL;
 
+        } else if ( tok == T_IDENT ) {
+            if ( !storeIdent() ) return T_MEMERR;
+
         } else if ( tok == T_STRLIT ) {
             if ( first ) return T_SYNERR;
             if ( !storeStrLit() ) return T_MEMERR;
@@ -638,17 +878,31 @@ uint16_t Tokenizer::tokenize() {
 
         } else {
             if ( tok < UINT16_C(0X0100) ) {
-                if ( !outBuf.writeByte( (uint8_t) tok ) ) return T_MEMERR;
+                if ( !out->writeByte( (uint8_t) tok ) ) return T_MEMERR;
             } else {
-                if ( !outBuf.writeToken( tok ) ) return T_MEMERR;
+                if ( !out->writeToken( tok ) ) return T_MEMERR;
             }
         }
 
         if ( tok == T_COLON ) stickyTok = T_EOL;
         else if ( locationToken( tok ) ) stickyTok = tok;
 
+        // GOTO name, GOSUB a, b, ...; after THEN, see labelRef()
+        bool target = ( tok == T_LABEL && !lineStart ) || 
+            ( tok == T_LINENO && !first );
+        wantTarget = locationToken( tok ) || ( tok == T_COMMA && wasTarget );
+        afterThen  = tok == KW_THEN;
+        wasTarget  = target;
+        lineStart  = first && tok == T_LINENO;
         first = false;
     }
 
 }
 
+uint16_t Tokenizer::tokenize( ByteBuffer& target ) {
+    ByteBuffer* save = out;
+    out = &target;
+    uint16_t tok = tokenize();
+    out = save;
+    return tok;
+}
@@ -60,21 +60,14 @@ class Tokenizer : public NonCopyable {
     int            numBase;
     // buffered output
     ByteBuffer     outBuf;
+    ByteBuffer*    out;     // &outBuf, or the target of tokenize( target )
 
-    void readIdent( uint8_t b );
+    void readIdent();
     
     static int digitVal( uint8_t b, int base );
     static bool isDigit( uint8_t b, int base );
     static int bitsPerDigit( int base );
-    static char* digitToBitGroup( char* buf, char* bufEnd, uint8_t b, 
-        int base );
-    static char* digitsToBitGroup( char* buf, char* bufEnd, 
-        const char* dig, int ndig, int base );
-    static char* digitsToHex( char* buf, int nbits );
-
-    uint16_t readNum( const char* buf, int len, int base, bool haveDot,
-        bool haveExp );
-    uint16_t readNum( uint8_t b, int base );
+
     uint16_t readNum( int base );
 
     bool storeLineNo();
@@ -85,6 +78,7 @@ class Tokenizer : public NonCopyable {
     bool storeStrLit();
     bool storeRem();
     bool identDecorated() const;
+    bool labelRef( bool afterThen ) const;
 
     static bool locationToken( uint16_t tok );
     static bool locationExprToken( uint16_t tok );
@@ -93,6 +87,9 @@ public:
     Tokenizer( const uint8_t* source_, size_t sourceLen_ );
     virtual ~Tokenizer();
 
+    // starts over on a new source line, keeping the output buffer
+    void reset( const uint8_t* source_, size_t sourceLen_ );
+
     // low-level interface ----------------------------------------
 
     inline const uint8_t* getPos() const { return pos; }
@@ -115,10 +112,26 @@ public:
     inline double numRVal() const { return realVal; }
     inline int numBase_() const { return numBase; }
 
+    // scans a numeric literal at p (first digit or dot; sign and base
+    // prefix already consumed) and advances p past it. Returns T_NUMLIT
+    // with rIntVal or rRealVal set according to rIsInt, or an error.
+    static uint16_t scanNum( const uint8_t*& p, const uint8_t* end, 
+        int base, int64_t& rIntVal, double& rRealVal, bool& rIsInt );
+
+    // converts the number at the start of a string: optional blanks 
+    // and sign, optional base prefix ($ % @, or &H &O &B), literal.
+    // Trailing characters are ignored. Returns T_NUMLIT on success.
+    static uint16_t strToNum( const uint8_t* p, size_t len, 
+        int64_t& rIntVal, double& rRealVal, bool& rIsInt );
+
     // high-level interface --------------------------------------
 
     uint16_t tokenize();    // stops and returns on error
 
+    // appends the tokens directly to target instead of the internal
+    // buffer; on error, target holds a partial line.
+    uint16_t tokenize( ByteBuffer& target );
+
     inline size_t getTokBufSz() const { return outBuf.getWritePos(); }
 
     inline uint8_t* getTokBufAddr() const { 
@@ -26,42 +26,59 @@ TokenScanner::TokenScanner() : pos(0) {}
 TokenScanner::TokenScanner( const uint8_t* pos_ ) : pos(pos_) {}
 TokenScanner::~TokenScanner() { pos = 0; }
 
-uint16_t TokenScanner::tokType() const {
-    uint8_t b = *pos;
-    if ( b == T_KWBNKC || b == T_KWBNKF || b == T_KWBNKK || b == T_OPBNKO ) {
-        uint8_t b2 = pos[1];
-        return ( ((uint16_t)b) << UINT8_C(8) ) | b2;
+#define ONE     UINT8_C(1)
+#define BNK     ( TK_BANK | UINT8_C(2) )
+#define SBI     UINT8_C(2)
+#define LNO     UINT8_C(4)
+#define TXT     TK_TEXT
+#define NUM     TK_NUM
+#define EOL     TK_EOL
+
+const uint8_t TokenScanner::tokKind[256] = {
+    EOL, ONE, ONE, BNK, ONE, TXT, BNK, TXT, LNO, NUM, ONE, BNK, TXT, ONE, ONE, BNK,   // 00
+    ONE, SBI, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // 10
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, TXT, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // 20
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // 30
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // 40
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // 50
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // 60
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // 70
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // 80
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // 90
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // A0
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // B0
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // C0
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // D0
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE,   // E0
+    ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE, ONE    // F0
+};
+
+#undef ONE
+#undef BNK
+#undef SBI
+#undef LNO
+#undef TXT
+#undef NUM
+#undef EOL
+
+const uint8_t TokenScanner::numSize[16] = {
+    3, 4, 6, 10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6, 10    // NL_I8 .. NL_F64
+};
+
+// T_EOL, text tokens and numeric literals
+bool TokenScanner::skipVarTok() {
+    uint8_t k = tokKind[*pos];
+    if ( k & TK_TEXT ) {
+        pos += 2 + pos[1];
+        return true;
     }
-    return b;
-}
-
-bool TokenScanner::skipTok() {
-    uint16_t tok = tokType();
-    switch ( tok ) {
-        uint8_t n, b;
-        case T_EOL: return false;
-        case T_SBI: pos += 2; break;
-        case T_LINENO: pos += 4; break;
-        case T_IDENT: case T_STRLIT: case T_LABEL: case T_REM:
-            n = pos[1];
-            pos += 2 + n;
-            break;
-        case T_NUMLIT:
-            b = pos[1] & UINT8_C(0X0F);
-            switch ( b ) {
-                case NL_I8: pos += 3; break;
-                case NL_I16: pos += 4; break;
-                case NL_I32: case NL_F32: pos += 6; break;
-                case NL_I64: case NL_F64: pos += 10; break;
-                default: return false;
-            }
-            break;
-        default:
-            if ( tok > UINT16_C(0X00FF) ) { pos += 2; return true; }
-            ++pos;
-            break;
+    if ( k & TK_NUM ) {
+        uint8_t n = numSize[ pos[1] & UINT8_C(0X0F) ];
+        if ( n == 0 ) return false;
+        pos += n;
+        return true;
     }
-    return true;
+    return false;   // T_EOL
 }
 
 bool TokenScanner::getText( const uint8_t*& rText, uint8_t& rLen ) const {
@@ -80,9 +97,7 @@ bool TokenScanner::getText( const uint8_t*& rText, uint8_t& rLen ) const {
 bool TokenScanner::getLineNo( uint32_t& rLineNo ) const {
     uint8_t b = *pos;
     if ( b != T_LINENO ) return false;
-    rLineNo = ( ((uint32_t)pos[1]) << UINT8_C(16) ) |
-              ( ((uint16_t)pos[2]) << UINT8_C( 8) ) |
-                           pos[3];
+    rLineNo = loadBE24( &pos[1] );
     return true;
 }
 
@@ -112,30 +127,17 @@ bool TokenScanner::getInt( int64_t& rVal ) const {
             rVal = (int8_t) pos[2];
             return true;
         case NL_I16:
-            rVal = (int16_t) ( ( ((uint16_t)pos[2]) << UINT8_C(8) ) | 
-                pos[3] );
+            rVal = (int16_t) loadBE16( &pos[2] );
             return true;
         case NL_I32: case NL_F32:
             U_IntReal32 ir32;
-            ir32.ival =
-              ( ((uint32_t)pos[2]) << UINT8_C(24) ) |
-              ( ((uint32_t)pos[3]) << UINT8_C(16) ) |
-              ( ((uint16_t)pos[4]) << UINT8_C( 8) ) |
-                           pos[5]                   ;
+            ir32.ival = loadBE32( &pos[2] );
             if ( b == NL_I32 ) { rVal = (int32_t) ir32.ival; return true; }
             rVal = (int64_t) truncf( ir32.rval );
             return true;
         case NL_I64: case NL_F64:
             U_IntReal64 ir64;
-            ir64.ival =
-              ( ((uint64_t)pos[2]) << UINT8_C(56) ) |
-              ( ((uint64_t)pos[3]) << UINT8_C(48) ) |
-              ( ((uint64_t)pos[4]) << UINT8_C(40) ) |
-              ( ((uint64_t)pos[5]) << UINT8_C(32) ) |
-              ( ((uint32_t)pos[6]) << UINT8_C(24) ) |
-              ( ((uint32_t)pos[7]) << UINT8_C(16) ) |
-              ( ((uint16_t)pos[8]) << UINT8_C( 8) ) |
-                           pos[9]                   ;
+            ir64.ival = loadBE64( &pos[2] );
             if ( b == NL_I64 ) { rVal = ir64.ival; return true; }
             rVal = (int64_t) trunc( ir64.rval );
             return true;
@@ -158,30 +160,17 @@ bool TokenScanner::getReal( double& rVal ) const {
             rVal = (double)( (int8_t) pos[2] );
             return true;
         case NL_I16:
-            rVal = (double)( (int16_t) ( ( ((uint16_t)pos[2]) << UINT8_C(8) ) | 
-                pos[3] ) );
+            rVal = (double)( (int16_t) loadBE16( &pos[2] ) );
             return true;
         case NL_I32: case NL_F32:
             U_IntReal32 ir32;
-            ir32.ival =
-              ( ((uint32_t)pos[2]) << UINT8_C(24) ) |
-              ( ((uint32_t)pos[3]) << UINT8_C(16) ) |
-              ( ((uint16_t)pos[4]) << UINT8_C( 8) ) |
-                           pos[5]                   ;
+            ir32.ival = loadBE32( &pos[2] );
             if ( b == NL_I32 ) { rVal = (double)( (int32_t) ir32.ival ); return true; }
             rVal = (double) ir32.rval;
             return true;
         case NL_I64: case NL_F64:
             U_IntReal64 ir64;
-            ir64.ival =
-              ( ((uint64_t)pos[2]) << UINT8_C(56) ) |
-              ( ((uint64_t)pos[3]) << UINT8_C(48) ) |
-              ( ((uint64_t)pos[4]) << UINT8_C(40) ) |
-              ( ((uint64_t)pos[5]) << UINT8_C(32) ) |
-              ( ((uint32_t)pos[6]) << UINT8_C(24) ) |
-              ( ((uint32_t)pos[7]) << UINT8_C(16) ) |
-              ( ((uint16_t)pos[8]) << UINT8_C( 8) ) |
-                           pos[9]                   ;
+            ir64.ival = loadBE64( &pos[2] );
             if ( b == NL_I64 ) { rVal = (double)( (int64_t) ir64.ival ); return true; }
             rVal = ir64.rval;
             return true;
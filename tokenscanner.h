@@ -31,10 +31,23 @@
 #include "tokens.h"
 #endif
 
+// token kinds by lead byte: bits 0..3 hold the size of fixed-size
+// tokens, the remaining bits tell how to size the others
+#define TK_SIZE     UINT8_C(0X0F)
+#define TK_BANK     UINT8_C(0X10)   // two-byte keyword / operator token
+#define TK_TEXT     UINT8_C(0X20)   // type, length, text
+#define TK_NUM      UINT8_C(0X40)   // type, subtype, value
+#define TK_EOL      UINT8_C(0X80)   // end of line
+
 class TokenScanner : public NonCopyable {
 
     const uint8_t* pos;
 
+    static const uint8_t tokKind[256];
+    static const uint8_t numSize[16];   // T_NUMLIT size by subtype
+
+    bool skipVarTok();
+
 public:
     TokenScanner();
     TokenScanner( const uint8_t* pos_ );
@@ -43,8 +56,20 @@ public:
     inline void setPos( const uint8_t* pos_ ) { pos = pos_; }
     inline const uint8_t* getPos() const { return pos; }
 
-    uint16_t tokType() const;
-    bool skipTok();
+    inline uint16_t tokType() const {
+        uint8_t b = *pos;
+        if ( tokKind[b] & TK_BANK ) {
+            return ( ((uint16_t)b) << UINT8_C(8) ) | pos[1];
+        }
+        return b;
+    }
+
+    inline bool skipTok() {
+        uint8_t n = tokKind[*pos] & TK_SIZE;
+        if ( n == 0 ) return skipVarTok();
+        pos += n;
+        return true;
+    }
 
     // T_IDENT, T_STRLIT, T_LABEL
     bool getText( const uint8_t*& rText, uint8_t& rLen ) const;
@@ -0,0 +1,83 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#include "tokenstream.h"
+#include "tokenscanner.h"
+
+void TokenStream::expand() {
+    size_t newAlloc = alloc * 2U;
+    XTok*  newXt    = new XTok [ newAlloc ];
+    if ( count ) {
+        memcpy( newXt, xt, sizeof(XTok) * count );
+    }
+    delete [] xt;
+    xt    = newXt;
+    alloc = newAlloc;
+}
+
+TokenStream::TokenStream( size_t minXTok ) {
+    xt    = new XTok [ minXTok ];
+    count = 0;
+    alloc = minXTok;
+}
+
+TokenStream::~TokenStream() {
+    delete [] xt; xt = 0; count = alloc = 0;
+}
+
+bool TokenStream::append( const uint8_t* line ) {
+    TokenScanner scan( line );
+    for (;;) {
+        if ( count >= alloc ) expand();
+        XTok& x = xt[count];
+        x.tok   = scan.tokType();
+        x.len   = 0;
+        x.isInt = false;
+        x.pad_  = 0;
+        x.ival  = 0;
+        switch ( x.tok ) {
+            case T_IDENT: case T_STRLIT: case T_LABEL: case T_REM:
+                scan.getText( x.text, x.len );
+                break;
+            case T_LINENO:
+                scan.getLineNo( x.lineNo );
+                break;
+            case T_NUMLIT: case T_SBI:
+                x.isInt = scan.isInt();
+                if ( x.isInt ) scan.getInt( x.ival );
+                else           scan.getReal( x.rval );
+                break;
+            default:
+                break;
+        }
+        const uint8_t* start = scan.getPos();
+        if ( !scan.skipTok() ) {
+            if ( x.tok != T_EOL ) return false;
+            x.size = 1U;
+            ++count;
+            return true;
+        }
+        x.size = (uint16_t)( scan.getPos() - start );
+        ++count;
+    }
+}
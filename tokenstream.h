@@ -0,0 +1,136 @@
+/*  PriamosBASIC - a BASIC interpreter written in C++
+    Copyright (C) 2019  Ekkehard Morgenstern
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+    NOTE: Programs created with PriamosBASIC do not fall under this license.
+
+    CONTACT INFO:
+        E-Mail: ekkehard@ekkehardmorgenstern.de
+        Mail: Ekkehard Morgenstern, Mozartstr. 1, D-76744 Woerth am Rhein, Germany, Europe */
+
+
+#ifndef TOKENSTREAM_H
+#define TOKENSTREAM_H   1
+
+#ifndef TYPES_H
+#include "types.h"
+#endif
+
+#ifndef TOKENS_H
+#include "tokens.h"
+#endif
+
+// initial token stream size (in records)
+#define MINXTOK     256U
+
+// a decoded token: fixed size, aligned, native-endian
+struct XTok {
+    uint16_t    tok;    // token type (as in TokenScanner::tokType())
+    uint16_t    size;   // size of the encoded token in bytes
+    uint8_t     len;    // T_IDENT, T_STRLIT, T_LABEL, T_REM: text length
+    bool        isInt;  // T_NUMLIT, T_SBI: integer value?
+    uint16_t    pad_;   // (padding)
+    union {
+        int64_t         ival;   // T_NUMLIT, T_SBI (isInt)
+        double          rval;   // T_NUMLIT (!isInt)
+        const uint8_t*  text;   // T_IDENT, T_STRLIT, T_LABEL, T_REM
+        uint32_t        lineNo; // T_LINENO
+    };
+};
+
+// decodes tokenized lines into an execution stream. Text pointers refer
+// to the tokenized source, which must stay in place while the stream
+// is in use.
+class TokenStream : public NonCopyable {
+
+    XTok*   xt;
+    size_t  count;
+    size_t  alloc;
+
+    void expand();
+
+public:
+    TokenStream( size_t minXTok = MINXTOK );
+    virtual ~TokenStream();
+
+    inline size_t getCount() const { return count; }
+    inline const XTok* getAt( size_t pos ) const { return &xt[pos]; }
+
+    // appends the tokens of one line, up to and including T_EOL.
+    // Returns false on a malformed token.
+    bool append( const uint8_t* line );
+
+    inline void clear() { count = 0; }
+};
+
+// reads an execution stream; same interface as TokenScanner
+class StreamScanner : public NonCopyable {
+
+    const XTok* pos;
+
+public:
+    inline StreamScanner() : pos(0) {}
+    inline StreamScanner( const XTok* pos_ ) : pos(pos_) {}
+
+    inline void setPos( const XTok* pos_ ) { pos = pos_; }
+    inline const XTok* getPos() const { return pos; }
+
+    inline uint16_t tokType() const { return pos->tok; }
+
+    inline bool skipTok() {
+        if ( pos->tok == T_EOL ) return false;
+        ++pos;
+        return true;
+    }
+
+    // T_IDENT, T_STRLIT, T_LABEL
+    inline bool getText( const uint8_t*& rText, uint8_t& rLen ) const {
+        switch ( pos->tok ) {
+            case T_IDENT: case T_STRLIT: case T_LABEL: case T_REM:
+                break;
+            default:
+                return false;
+        }
+        rText = pos->text;
+        rLen  = pos->len;
+        return true;
+    }
+
+    // T_LINENO
+    inline bool getLineNo( uint32_t& rLineNo ) const {
+        if ( pos->tok != T_LINENO ) return false;
+        rLineNo = pos->lineNo;
+        return true;
+    }
+
+    // T_NUMLIT, T_SBI
+    inline bool isInt() const {
+        return ( pos->tok == T_NUMLIT || pos->tok == T_SBI ) && pos->isInt;
+    }
+
+    inline bool getInt( int64_t& rVal ) const {
+        if ( pos->tok != T_NUMLIT && pos->tok != T_SBI ) return false;
+        rVal = pos->isInt ? pos->ival : (int64_t) trunc( pos->rval );
+        return true;
+    }
+
+    inline bool getReal( double& rVal ) const {
+        if ( pos->tok != T_NUMLIT && pos->tok != T_SBI ) return false;
+        rVal = pos->isInt ? (double) pos->ival : pos->rval;
+        return true;
+    }
+};
+
+#endif
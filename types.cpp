@@ -22,6 +22,8 @@
 
 #include "types.h"
 
+#include <unistd.h>
+
 NonCopyable::NonCopyable() {}
 NonCopyable::~NonCopyable() {}
 
@@ -33,6 +35,13 @@ double getTime() {
         1.0e9 );
 }
 
+int getNumCPUs() {
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+    if ( n < 1L ) return 1;
+    if ( n > 64L ) return 64;
+    return (int) n;
+}
+
 void hexDump( const void* addr, size_t size ) {
     static const char hex[] = "0123456789ABCDEF";
     const uint8_t* ptr = (const uint8_t*) addr;
@@ -80,7 +89,7 @@ void format( uint8_t*& rOut, size_t& rLen, const char* fmt, ... ) {
     } else if ( len >= 1024 ) {
         tmp2 = new uint8_t [ len + 1 ];
         va_start( ap, fmt );
-        int len2 = vsnprintf( (char*) tmp, len+1, fmt, ap );
+        int len2 = vsnprintf( (char*) tmp2, len+1, fmt, ap );
         va_end( ap );
         if ( len2 < 0 ) {
             len = 0;
@@ -95,3 +104,322 @@ void format( uint8_t*& rOut, size_t& rLen, const char* fmt, ... ) {
     rLen = len;
     if ( len ) memcpy( rOut, tmp, len );
 }
+
+// --- number formatting -------------------------------------------------------
+
+static const char digitPairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233"
+    "34353637383940414243444546474849505152535455565758596061626364656667"
+    "6869707172737475767778798081828384858687888990919293949596979899";
+
+static inline int countDigits( uint64_t v ) {
+    int n = 1;
+    for (;;) {
+        if ( v < 10U    ) return n;
+        if ( v < 100U   ) return n + 1;
+        if ( v < 1000U  ) return n + 2;
+        if ( v < 10000U ) return n + 3;
+        v /= 10000U; n += 4;
+    }
+}
+
+size_t fmtUInt( char* buf, uint64_t v ) {
+    int   n = countDigits( v );
+    char* p = buf + n;
+    while ( v >= 100U ) {
+        unsigned i = (unsigned)( v % 100U ) * 2U; v /= 100U;
+        *--p = digitPairs[i+1U]; *--p = digitPairs[i];
+    }
+    if ( v >= 10U ) {
+        unsigned i = (unsigned) v * 2U;
+        *--p = digitPairs[i+1U]; *--p = digitPairs[i];
+    } else {
+        *--p = (char)( '0' + v );
+    }
+    return (size_t) n;
+}
+
+size_t fmtInt( char* buf, int64_t v ) {
+    if ( v >= 0 ) return fmtUInt( buf, (uint64_t) v );
+    *buf = '-';
+    return 1U + fmtUInt( buf + 1, 0U - (uint64_t) v );
+}
+
+// Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly and 
+// Accurately with Integers"): digits that read back as the same double,
+// and nearly always the shortest such digits
+
+struct DiyFp {
+    uint64_t    f;
+    int         e;
+
+    DiyFp() : f(0), e(0) {}
+    DiyFp( uint64_t f_, int e_ ) : f(f_), e(e_) {}
+
+    DiyFp operator-( const DiyFp& rhs ) const { return DiyFp( f - rhs.f, e ); }
+
+    DiyFp operator*( const DiyFp& rhs ) const {
+        const uint64_t M32 = UINT64_C(0XFFFFFFFF);
+        uint64_t a = f >> 32, b = f & M32, c = rhs.f >> 32, d = rhs.f & M32;
+        uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+        uint64_t tmp = ( bd >> 32 ) + ( ad & M32 ) + ( bc & M32 );
+        tmp += UINT64_C(1) << 31;   // round
+        return DiyFp( ac + ( ad >> 32 ) + ( bc >> 32 ) + ( tmp >> 32 ), 
+            e + rhs.e + 64 );
+    }
+
+    DiyFp normalize() const {
+        DiyFp r = *this;
+        while ( !( r.f & ( UINT64_C(1) << 63 ) ) ) { r.f <<= 1; --r.e; }
+        return r;
+    }
+};
+
+#define DP_SIGNIFICAND  UINT64_C(0X000FFFFFFFFFFFFF)
+#define DP_HIDDENBIT    UINT64_C(0X0010000000000000)
+#define DP_EXPBIAS      1075
+
+// normalized 10^k for k = -348, -340, ..., 340
+static const uint64_t cachedPowF[87] = {
+    UINT64_C(0XFA8FD5A0081C0288), UINT64_C(0XBAAEE17FA23EBF76), UINT64_C(0X8B16FB203055AC76),
+    UINT64_C(0XCF42894A5DCE35EA), UINT64_C(0X9A6BB0AA55653B2D), UINT64_C(0XE61ACF033D1A45DF),
+    UINT64_C(0XAB70FE17C79AC6CA), UINT64_C(0XFF77B1FCBEBCDC4F), UINT64_C(0XBE5691EF416BD60C),
+    UINT64_C(0X8DD01FAD907FFC3C), UINT64_C(0XD3515C2831559A83), UINT64_C(0X9D71AC8FADA6C9B5),
+    UINT64_C(0XEA9C227723EE8BCB), UINT64_C(0XAECC49914078536D), UINT64_C(0X823C12795DB6CE57),
+    UINT64_C(0XC21094364DFB5637), UINT64_C(0X9096EA6F3848984F), UINT64_C(0XD77485CB25823AC7),
+    UINT64_C(0XA086CFCD97BF97F4), UINT64_C(0XEF340A98172AACE5), UINT64_C(0XB23867FB2A35B28E),
+    UINT64_C(0X84C8D4DFD2C63F3B), UINT64_C(0XC5DD44271AD3CDBA), UINT64_C(0X936B9FCEBB25C996),
+    UINT64_C(0XDBAC6C247D62A584), UINT64_C(0XA3AB66580D5FDAF6), UINT64_C(0XF3E2F893DEC3F126),
+    UINT64_C(0XB5B5ADA8AAFF80B8), UINT64_C(0X87625F056C7C4A8B), UINT64_C(0XC9BCFF6034C13053),
+    UINT64_C(0X964E858C91BA2655), UINT64_C(0XDFF9772470297EBD), UINT64_C(0XA6DFBD9FB8E5B88F),
+    UINT64_C(0XF8A95FCF88747D94), UINT64_C(0XB94470938FA89BCF), UINT64_C(0X8A08F0F8BF0F156B),
+    UINT64_C(0XCDB02555653131B6), UINT64_C(0X993FE2C6D07B7FAC), UINT64_C(0XE45C10C42A2B3B06),
+    UINT64_C(0XAA242499697392D3), UINT64_C(0XFD87B5F28300CA0E), UINT64_C(0XBCE5086492111AEB),
+    UINT64_C(0X8CBCCC096F5088CC), UINT64_C(0XD1B71758E219652C), UINT64_C(0X9C40000000000000),
+    UINT64_C(0XE8D4A51000000000), UINT64_C(0XAD78EBC5AC620000), UINT64_C(0X813F3978F8940984),
+    UINT64_C(0XC097CE7BC90715B3), UINT64_C(0X8F7E32CE7BEA5C70), UINT64_C(0XD5D238A4ABE98068),
+    UINT64_C(0X9F4F2726179A2245), UINT64_C(0XED63A231D4C4FB27), UINT64_C(0XB0DE65388CC8ADA8),
+    UINT64_C(0X83C7088E1AAB65DB), UINT64_C(0XC45D1DF942711D9A), UINT64_C(0X924D692CA61BE758),
+    UINT64_C(0XDA01EE641A708DEA), UINT64_C(0XA26DA3999AEF774A), UINT64_C(0XF209787BB47D6B85),
+    UINT64_C(0XB454E4A179DD1877), UINT64_C(0X865B86925B9BC5C2), UINT64_C(0XC83553C5C8965D3D),
+    UINT64_C(0X952AB45CFA97A0B3), UINT64_C(0XDE469FBD99A05FE3), UINT64_C(0XA59BC234DB398C25),
+    UINT64_C(0XF6C69A72A3989F5C), UINT64_C(0XB7DCBF5354E9BECE), UINT64_C(0X88FCF317F22241E2),
+    UINT64_C(0XCC20CE9BD35C78A5), UINT64_C(0X98165AF37B2153DF), UINT64_C(0XE2A0B5DC971F303A),
+    UINT64_C(0XA8D9D1535CE3B396), UINT64_C(0XFB9B7CD9A4A7443C), UINT64_C(0XBB764C4CA7A44410),
+    UINT64_C(0X8BAB8EEFB6409C1A), UINT64_C(0XD01FEF10A657842C), UINT64_C(0X9B10A4E5E9913129),
+    UINT64_C(0XE7109BFBA19C0C9D), UINT64_C(0XAC2820D9623BF429), UINT64_C(0X80444B5E7AA7CF85),
+    UINT64_C(0XBF21E44003ACDD2D), UINT64_C(0X8E679C2F5E44FF8F), UINT64_C(0XD433179D9C8CB841),
+    UINT64_C(0X9E19DB92B4E31BA9), UINT64_C(0XEB96BF6EBADF77D9), UINT64_C(0XAF87023B9BF0EE6B)
+};
+
+static const int16_t cachedPowE[87] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static const uint32_t pow10Tab[10] = { 1U, 10U, 100U, 1000U, 10000U, 
+    100000U, 1000000U, 10000000U, 100000000U, 1000000000U };
+
+static void grisuRound( char* buf, int len, uint64_t delta, uint64_t rest,
+    uint64_t tenKappa, uint64_t wpw ) {
+    while ( rest < wpw && delta - rest >= tenKappa &&
+        ( rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw ) ) {
+        --buf[len-1];
+        rest += tenKappa;
+    }
+}
+
+static void digitGen( const DiyFp& w, const DiyFp& mp, uint64_t delta,
+    char* buf, int& rLen, int& rK ) {
+    const DiyFp one( UINT64_C(1) << -mp.e, mp.e );
+    const DiyFp wpw = mp - w;
+    uint32_t p1 = (uint32_t)( mp.f >> -one.e );
+    uint64_t p2 = mp.f & ( one.f - 1U );
+    int kappa = countDigits( p1 );
+    rLen = 0;
+    while ( kappa > 0 ) {
+        uint32_t div = pow10Tab[kappa-1];
+        uint32_t d   = p1 / div;
+        p1 %= div;
+        if ( d || rLen ) buf[rLen++] = (char)( '0' + d );
+        --kappa;
+        uint64_t rest = ( ( (uint64_t) p1 ) << -one.e ) + p2;
+        if ( rest <= delta ) {
+            rK += kappa;
+            grisuRound( buf, rLen, delta, rest, 
+                ( (uint64_t) pow10Tab[kappa] ) << -one.e, wpw.f );
+            return;
+        }
+    }
+    for (;;) {
+        p2 *= 10U; delta *= 10U;
+        char d = (char)( p2 >> -one.e );
+        if ( d || rLen ) buf[rLen++] = (char)( '0' + d );
+        p2 &= one.f - 1U;
+        --kappa;
+        if ( p2 < delta ) {
+            rK += kappa;
+            int i = -kappa;
+            grisuRound( buf, rLen, delta, p2, one.f, 
+                wpw.f * ( i < 10 ? pow10Tab[i] : 0U ) );
+            return;
+        }
+    }
+}
+
+// digits of a positive, finite v: v = digits * 10^rK
+static int grisu2( double v, char* buf, int& rK ) {
+    uint64_t bits; memcpy( &bits, &v, sizeof(bits) );
+    int      be = (int)( ( bits >> 52 ) & 0X7FFU );
+    DiyFp    w;
+    if ( be ) {
+        w = DiyFp( ( bits & DP_SIGNIFICAND ) + DP_HIDDENBIT, be - DP_EXPBIAS );
+    } else {
+        w = DiyFp( bits & DP_SIGNIFICAND, 1 - DP_EXPBIAS );
+    }
+    // boundaries: halfway to the neighbouring doubles
+    DiyFp mp = DiyFp( ( w.f << 1 ) + 1U, w.e - 1 ).normalize();
+    DiyFp mm = w.f == DP_HIDDENBIT ? DiyFp( ( w.f << 2 ) - 1U, w.e - 2 ) :
+        DiyFp( ( w.f << 1 ) - 1U, w.e - 1 );
+    mm.f <<= mm.e - mp.e; mm.e = mp.e;
+    // a cached power that brings the exponent into [-60, -32]
+    double dk = ( -61 - mp.e ) * 0.30102999566398114 + 347;
+    int    k  = (int) dk;
+    if ( dk - k > 0.0 ) ++k;
+    int    i  = ( k >> 3 ) + 1;
+    rK = 348 - i * 8;
+    DiyFp c( cachedPowF[i], cachedPowE[i] );
+    DiyFp W  = w.normalize() * c;
+    DiyFp Wp = mp * c, Wm = mm * c;
+    ++Wm.f; --Wp.f;
+    int len;
+    digitGen( W, Wp, Wp.f - Wm.f, buf, len, rK );
+    return len;
+}
+
+// Grisu2 digits are not always the closest ones (0.1 + 0.2 comes out as
+// 0.30000000000000007). Below 16 digits, at most one candidate fits 
+// between the neighbouring doubles, so this only affects long results.
+// For those, the C library's correctly rounded digits of the same 
+// length are used: if any n digits read back the same, these do.
+static int exactDigits( double v, int n, char* buf, int& rK ) {
+    char tmp[FMT_REALSZ];
+    snprintf( tmp, sizeof(tmp), "%.*e", n - 1, v );
+    // d.dddde[+-]x
+    char* p = tmp;
+    n = 0;
+    for ( ; *p != 'e'; ++p ) if ( *p != '.' ) buf[n++] = *p;
+    int e = atoi( p + 1 );
+    while ( n > 1 && buf[n-1] == '0' ) --n;
+    rK = e - n + 1;
+    return n;
+}
+
+// true if the digits d * 10^k read back as v
+static bool readsBack( double v, const char* d, int n, int k ) {
+    char tmp[FMT_REALSZ];
+    memcpy( tmp, d, n );
+    tmp[n] = 'e';
+    tmp[ n + 1 + fmtInt( tmp + n + 1, k ) ] = '\0';
+    return strtod( tmp, 0 ) == v;
+}
+
+// d * 10^k with its last digit dropped, rounded up or down
+static int dropDigit( const char* d, int n, bool up, char* buf, int& rK ) {
+    int m = n - 1;
+    memcpy( buf, d, m );
+    rK += 1;
+    if ( up ) {
+        int i = m - 1;
+        while ( i >= 0 && buf[i] == '9' ) buf[i--] = '0';
+        if ( i >= 0 ) {
+            ++buf[i];
+        } else {
+            buf[0] = '1'; m = 1; rK += n - 1;   // 999..9 -> 1
+        }
+    }
+    while ( m > 1 && buf[m-1] == '0' ) { --m; ++rK; }
+    return m;
+}
+
+// replaces d * 10^k by a form with one digit less if that reads back
+// as v. It must be within half an ULP of v, while the digits are within
+// half a unit: it is only tried if it can be that close. The digits 
+// are rounded already, so at a 5 both ways are tried
+static bool shorterDigits( double v, double relUlp, char* d, int& rN, 
+    int& rK ) {
+    int    n  = rN;
+    double sd = 0;
+    for ( int i=0; i < n; ++i ) sd = sd * 10.0 + ( d[i] - '0' );
+    int last = d[n-1] - '0';
+    int dist = last < 10 - last ? last : 10 - last;
+    if ( dist - 0.5 > relUlp * sd * 0.5 * 1.001 ) return false;
+    char shorter[24];
+    int  ks = rK;
+    int  ns = dropDigit( d, n, last >= 5, shorter, ks );
+    if ( !readsBack( v, shorter, ns, ks ) ) {
+        if ( last != 5 ) return false;
+        ks = rK;
+        ns = dropDigit( d, n, false, shorter, ks );
+        if ( !readsBack( v, shorter, ns, ks ) ) return false;
+    }
+    memcpy( d, shorter, ns ); rN = ns; rK = ks;
+    return true;
+}
+
+size_t fmtReal( char* buf, double v ) {
+    char* p = buf;
+    if ( v != v ) { memcpy( p, "nan", 3U ); return 3U; }
+    if ( signbit( v ) ) { *p++ = '-'; v = -v; }
+    if ( v == 0.0 ) { *p++ = '0'; return p - buf; }
+    if ( isinf( v ) ) { memcpy( p, "inf", 3U ); return p - buf + 3U; }
+
+    char digits[24];
+    int  k;
+    int  n  = grisu2( v, digits, k );
+    if ( n >= 16 ) {
+        n = exactDigits( v, n, digits, k );
+        // Grisu2 may give a digit or two too many (1E23)
+        double relUlp = ( nextafter( v, HUGE_VAL ) - v ) / v;
+        while ( n > 1 && shorterDigits( v, relUlp, digits, n, k ) ) {}
+    }
+    int  kk = n + k;    // 10^(kk-1) <= v < 10^kk
+
+    if ( kk > 0 && kk <= FMT_REALFIX ) {
+        // 1234, 1234000, 12.34
+        if ( kk >= n ) {
+            memcpy( p, digits, n ); p += n;
+            memset( p, '0', kk - n ); p += kk - n;
+        } else {
+            memcpy( p, digits, kk ); p += kk;
+            *p++ = '.';
+            memcpy( p, digits + kk, n - kk ); p += n - kk;
+        }
+    } else if ( kk <= 0 && kk > -5 ) {
+        // 0.001234
+        *p++ = '0'; *p++ = '.';
+        memset( p, '0', -kk ); p += -kk;
+        memcpy( p, digits, n ); p += n;
+    } else {
+        // 1.234e+56, 1e-07
+        *p++ = digits[0];
+        if ( n > 1 ) {
+            *p++ = '.';
+            memcpy( p, digits + 1, n - 1 ); p += n - 1;
+        }
+        int e = kk - 1;
+        *p++ = 'e';
+        *p++ = e < 0 ? '-' : '+';
+        if ( e < 0 ) e = -e;
+        if ( e < 10 ) *p++ = '0';
+        p += fmtUInt( p, (uint64_t) e );
+    }
+    return p - buf;
+}
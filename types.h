@@ -50,6 +50,8 @@ public:
 
 double getTime();
 
+int getNumCPUs();   // number of processors online (at least 1)
+
 union U_IntReal64 {
     uint64_t    ival;
     double      rval;
@@ -60,8 +62,69 @@ union U_IntReal32 {
     float       rval;
 };
 
+// big-endian loads and stores at arbitrary (unaligned) addresses
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BE16( x )   (x)
+#define BE32( x )   (x)
+#define BE64( x )   (x)
+#else
+#define BE16( x )   __builtin_bswap16( x )
+#define BE32( x )   __builtin_bswap32( x )
+#define BE64( x )   __builtin_bswap64( x )
+#endif
+
+inline uint16_t loadBE16( const uint8_t* p ) {
+    uint16_t v; memcpy( &v, p, sizeof(v) ); return BE16( v );
+}
+
+inline uint32_t loadBE24( const uint8_t* p ) {
+    return ( ((uint32_t)p[0]) << UINT8_C(16) ) | 
+           ( ((uint16_t)p[1]) << UINT8_C( 8) ) | p[2];
+}
+
+inline uint32_t loadBE32( const uint8_t* p ) {
+    uint32_t v; memcpy( &v, p, sizeof(v) ); return BE32( v );
+}
+
+inline uint64_t loadBE64( const uint8_t* p ) {
+    uint64_t v; memcpy( &v, p, sizeof(v) ); return BE64( v );
+}
+
+inline void storeBE16( uint8_t* p, uint16_t v ) {
+    v = BE16( v ); memcpy( p, &v, sizeof(v) );
+}
+
+inline void storeBE24( uint8_t* p, uint32_t v ) {
+    p[0] = (uint8_t)( v >> UINT8_C(16) );
+    p[1] = (uint8_t)( v >> UINT8_C( 8) );
+    p[2] = (uint8_t)  v;
+}
+
+inline void storeBE32( uint8_t* p, uint32_t v ) {
+    v = BE32( v ); memcpy( p, &v, sizeof(v) );
+}
+
+inline void storeBE64( uint8_t* p, uint64_t v ) {
+    v = BE64( v ); memcpy( p, &v, sizeof(v) );
+}
+
 void hexDump( const void* addr, size_t size );
 
 void format( uint8_t*& rOut, size_t& rLen, const char* fmt, ... );
 
+// number formatting into a caller's buffer (no terminating NUL), 
+// without allocating. Return the number of characters written.
+
+#define FMT_INTSZ       24U     // buffer size for fmtInt(), fmtUInt()
+#define FMT_REALSZ      32U     // buffer size for fmtReal()
+#define FMT_REALFIX     17      // digits before the point without exponent
+
+size_t fmtUInt( char* buf, uint64_t v );
+size_t fmtInt( char* buf, int64_t v );
+
+// the shortest digits that read back as the same value, in fixed 
+// notation for 1e-5 <= |v| < 1e17 and as 1.5e+20 otherwise; "inf", 
+// "nan". Integral values have no point: 1e10 gives 10000000000
+size_t fmtReal( char* buf, double v );
+
 #endif
@@ -55,6 +55,32 @@ void ValDesc::setStrVal( const uint8_t* ptr, size_t len, bool bFree_ ) {}
 void ValDesc::alu( uint16_t op ) {}
 void ValDesc::alu( uint16_t op, ValDesc* arg ) {}
 
+// string to number conversions (0 if the string does not start with a number)
+
+static int64_t strToInt( const uint8_t* ptr, size_t len ) {
+    int64_t ival; double rval; bool isInt;
+    if ( Tokenizer::strToNum( ptr, len, ival, rval, isInt ) != T_NUMLIT ) {
+        return 0;
+    }
+    return isInt ? ival : (int64_t) trunc( rval );
+}
+
+static double strToReal( const uint8_t* ptr, size_t len ) {
+    int64_t ival; double rval; bool isInt;
+    if ( Tokenizer::strToNum( ptr, len, ival, rval, isInt ) != T_NUMLIT ) {
+        return 0;
+    }
+    return isInt ? (double) ival : rval;
+}
+
+// number to string: an owned copy of the text formatted on the stack
+static void newText( uint8_t*& rOut, size_t& rLen, const char* buf, 
+    size_t len ) {
+    rOut = new uint8_t [ len ];
+    rLen = len;
+    memcpy( rOut, buf, len );
+}
+
 // --- IntVal -------------------------------------------------------------------------
 
 IntVal::IntVal() : ValDesc(VT_INT), value(0) {}
@@ -67,29 +93,13 @@ double IntVal::getRealVal() const { return (double) value; }
 void IntVal::setRealVal( double val ) { value = (int64_t) trunc( val ); }
 
 void IntVal::getStrVal( uint8_t*& rPtr, size_t& rLen, bool& rFree ) const {    
-    format( rPtr, rLen, "%" PRId64, value );
+    char buf[FMT_INTSZ];
+    newText( rPtr, rLen, buf, fmtInt( buf, value ) );
     rFree = true;
 }
 
 void IntVal::setStrVal( const uint8_t* ptr, size_t len, bool bFree_ ) {
-    Tokenizer t( ptr, len );
-    uint16_t tok = t.nextTok(); bool minus = false;
-    if ( tok == T_MINUS ) {
-        minus = true;
-        tok   = t.nextTok();
-    } else if ( tok == T_PLUS ) {
-        tok   = t.nextTok();
-    }
-    if ( tok == T_NUMLIT ) {
-        if ( t.numIsInt() ) {
-            value = t.numIVal();
-        } else {
-            value = (int64_t) trunc( t.numRVal() );
-        }
-        if ( minus ) value = -value;
-    } else {
-        value = 0;
-    }
+    value = strToInt( ptr, len );
 }
 
 void IntVal::alu( uint16_t op ) {
@@ -175,29 +185,13 @@ double RealVal::getRealVal() const { return value; }
 void RealVal::setRealVal( double val ) { value = val; }
 
 void RealVal::getStrVal( uint8_t*& rPtr, size_t& rLen, bool& rFree ) const {
-    format( rPtr, rLen, "%g", value );
+    char buf[FMT_REALSZ];
+    newText( rPtr, rLen, buf, fmtReal( buf, value ) );
     rFree = true;
 }
 
 void RealVal::setStrVal( const uint8_t* ptr, size_t len, bool bFree_ ) {
-    Tokenizer t( ptr, len );
-    uint16_t tok = t.nextTok(); bool minus = false;
-    if ( tok == T_MINUS ) {
-        minus = true;
-        tok   = t.nextTok();
-    } else if ( tok == T_PLUS ) {
-        tok   = t.nextTok();
-    }
-    if ( tok == T_NUMLIT ) {
-        if ( t.numIsInt() ) {
-            value = (double) t.numIVal();
-        } else {
-            value = t.numRVal();
-        }
-        if ( minus ) value = -value;
-    } else {
-        value = 0;
-    }
+    value = strToReal( ptr, len );
 }
 
 void RealVal::alu( uint16_t op ) {
@@ -279,28 +273,26 @@ StrVal::~StrVal() {
 }
 
 int64_t StrVal::getIntVal() const { 
-    IntVal tmp;
-    tmp.setStrVal( text, len, false );
-    return tmp.value;
+    return strToInt( text, len );
 }
 
 void StrVal::setIntVal( int64_t val ) {
     if ( bFree && text ) delete [] text;
     text = 0; len = 0;
-    format( text, len, "%" PRId64, val );
+    char buf[FMT_INTSZ];
+    newText( text, len, buf, fmtInt( buf, val ) );
     bFree = true;
 }
 
 double StrVal::getRealVal() const { 
-    RealVal tmp;
-    tmp.setStrVal( text, len, false );
-    return tmp.value;
+    return strToReal( text, len );
 }
 
 void StrVal::setRealVal( double val ) {
     if ( bFree && text ) delete [] text;
     text = 0; len = 0;
-    format( text, len, "%g", val );
+    char buf[FMT_REALSZ];
+    newText( text, len, buf, fmtReal( buf, val ) );
     bFree = true;
 }
 
@@ -381,10 +373,17 @@ void StrVal::alu( uint16_t op, ValDesc* arg ) {
 // --- AryHashEnt --------------------------------------------------------------------
 
 AryHashEnt::AryHashEnt( size_t cellIndex_, const uint8_t* name_, size_t nameLen_ )
-    :   HashEntry( name_, nameLen_ ), cellIndex(cellIndex_) {}
+    :   HashEntry( name_, nameLen_, HN_INLINE, sizeof(AryHashEnt) ), 
+        cellIndex(cellIndex_) {}
 
 AryHashEnt::~AryHashEnt() { cellIndex = SIZE_MAX; }
 
+AryHashEnt* AryHashEnt::create( size_t cellIndex_, const uint8_t* name_, 
+    size_t nameLen_, HashArena* arena ) {
+    return new( HashInline( nameLen_, arena ) ) AryHashEnt( cellIndex_, name_, 
+        nameLen_ );
+}
+
 // --- AryVal ------------------------------------------------------------------------
 
 void AryVal::init() {
@@ -417,7 +416,7 @@ void AryVal::init() {
         cells[i] = ValDesc::create( elemType );
     }
     if ( arrayType == AT_ASSOC ) {
-        ht = new HashTable();
+        ht = new HashTable( true );
     } else {
         ht = 0;
     }
@@ -611,7 +610,7 @@ ValDesc* AryVal::subscriptAssoc( ValDesc** args ) {
     totalSize = index + 1U;
     ValDesc* cell = cells[index];
     // add it to the hash table
-    ht->enter( new AryHashEnt( index, key, keyLen ) );
+    ht->enter( AryHashEnt::create( index, key, keyLen, ht->getArena() ) );
     if ( bFree ) delete [] key;
     // return accessed cell
     return cell;
@@ -720,23 +719,29 @@ void FuncVal::call() {
 
 
 VarDesc::VarDesc( const uint8_t* name, size_t nameLen,
-    ValDesc* valueDesc_ ) : HashEntry( name, nameLen ),
-    valueDesc(valueDesc_) {}
+    ValDesc* valueDesc_ ) : HashEntry( name, nameLen, HN_INLINE, 
+    sizeof(VarDesc) ), valueDesc(valueDesc_) {}
 
 VarDesc::~VarDesc() { 
     if ( valueDesc ) { delete valueDesc; valueDesc = 0; }
 }
 
+VarDesc* VarDesc::create( const uint8_t* name, size_t nameLen,
+    ValDesc* valueDesc_, HashArena* arena ) {
+    return new( HashInline( nameLen, arena ) ) VarDesc( name, nameLen, 
+        valueDesc_ );
+}
+
 // --- Variables --------------------------------------------------------------------
 
-Variables::Variables() {}
+Variables::Variables() : ht(true) {}
 Variables::~Variables() {}
 
 bool Variables::addVar( const uint8_t* name, size_t nameLen, 
     ValDesc* desc ) {
     if ( ht.find( name, nameLen ) ) return false;
     
-    ht.enter( new VarDesc( name, nameLen, desc ) );
+    ht.enter( VarDesc::create( name, nameLen, desc, ht.getArena() ) );
 
     return true;
 }
@@ -748,7 +753,7 @@ bool Variables::remVar( const uint8_t* name, size_t nameLen ) {
 
     ht.remove( ent );
 
-    delete ent;
+    ht.release( ent );
     return true;
 }
 
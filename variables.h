@@ -136,8 +136,13 @@ struct AryHashEnt : public HashEntry {
 
     size_t  cellIndex;
 
-    AryHashEnt( size_t cellIndex_, const uint8_t* name_, size_t nameLen_ );
     virtual ~AryHashEnt();
+
+    static AryHashEnt* create( size_t cellIndex_, const uint8_t* name_, 
+        size_t nameLen_, HashArena* arena );
+
+private:
+    AryHashEnt( size_t cellIndex_, const uint8_t* name_, size_t nameLen_ );
 };
 
 struct AryVal : public ValDesc {
@@ -215,9 +220,13 @@ struct FuncVal : public ValDesc {
 struct VarDesc : public HashEntry {    // variable descriptor
     ValDesc*    valueDesc;
 
-    VarDesc( const uint8_t* name, size_t nameLen,
-        ValDesc* valueDesc_ );
     virtual ~VarDesc();
+
+    static VarDesc* create( const uint8_t* name, size_t nameLen,
+        ValDesc* valueDesc_, HashArena* arena );
+
+private:
+    VarDesc( const uint8_t* name, size_t nameLen, ValDesc* valueDesc_ );
 };
 
 #define INITIAL_DESCBUF_SIZE    131072U
@@ -233,6 +242,7 @@ public:
     bool addVar( const uint8_t* name, size_t nameLen, 
         ValDesc* desc );
 
+    // the variable's memory comes back with the next clear()
     bool remVar( const uint8_t* name, size_t nameLen );
 
     inline void clear() { ht.clear(); }